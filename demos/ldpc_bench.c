@@ -0,0 +1,619 @@
+/*
+ * In-memory encoding/decoding benchmark.
+ * For each point of a grid (SessionType x block size k x FEC ratio x symbol
+ * size), a block is encoded, then decoded from its symbols received in
+ * random order until decoding completes. For each point are reported:
+ * - the session initialization times (the coder builds the parity check
+ *   matrix, the decoder finds it in the matrix cache),
+ * - the encoding and decoding throughputs, in MB/s of source data and in
+ *   symbols/s (source + parity symbols processed),
+ * - the decoding overhead, i.e. the number of symbols needed divided by k,
+ * - the peak memory (RSS) and stack used by the decoder, read from
+ *   /proc/self/status.
+ * The decoded source symbols are compared with the original ones: the
+ * trials where one of them differs are reported as corrupt, and make the
+ * run fail.
+ * With several trials, times and overhead are averaged, and the peak
+ * memory is the maximum.
+ * With -g, the setup costs are measured instead: parity check matrix
+ * built by CreatePchkMatrix (then compressed) and by
+ * CreatePchkMatrixCompressed, which must give the same matrix, and
+ * decoder session set up with InitSession/EndSession (the matrix being
+ * cached) or recycled with ResetSession after a block was decoded.
+ * With -c, the sessions build their matrix another way (FLAG_NO4CYCLE,
+ * FLAG_PEG), e.g. to compare the decoding overheads. These constructions
+ * do not apply to qcstairs, whose points are then skipped.
+ *
+ * Usage: ldpc_bench [-t type[,type...]] [-r ratio[,ratio...]]
+ *		     [-s size[,size...]] [-l length] [-n trials] [-b] [-p threads]
+ *		     [-m] [-o] [-c construction[,construction]] [-g] [-j] [k ...]
+ *	-t	session types among ldgm, stairs, triangle and qcstairs
+ *		(default stairs)
+ *	-r	FEC ratios n/k (default 1.5)
+ *	-s	symbol sizes in bytes (default 64)
+ *	-l	length of the source symbols in bytes, when shorter than the
+ *		symbol size (default 0: the whole symbol). MB/s are then
+ *		given for this length.
+ *	-n	number of trials per point (default 1)
+ *	-b	encodes with EncodeBlock instead of BuildParitySymbol calls
+ *	-p	encodes with EncodeBlockParallel on that many threads (0 for
+ *		one per CPU)
+ *	-m	enables ML decoding (see SetMLDecoding)
+ *	-o	symbols are received in buffers of the decoder, then given to
+ *		it with DecodingWithOwnedSymbol (the reception copy is timed)
+ *	-c	parity check matrix construction: no4cycle and/or peg
+ *		(default: neither)
+ *	-g	measures the setup costs (see above)
+ *	-j	JSON output, one object per point
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/ldpc_fec.h"
+
+#define SEED		2003	// Seed used to initialize LDPCFecSession
+#define LEFT_DEGREE	3	// Left degree of data nodes in the checks graph
+#define MAX_VALUES	16	// Max number of values per grid dimension
+
+/* Results of one point of the grid */
+typedef struct {
+	double	encInit;	// coder InitSession, in s
+	double	encTime;	// all BuildParitySymbol calls, in s
+	double	decInit;	// decoder InitSession, in s
+	double	decTime;	// all DecodingWithSymbol calls, in s
+	double	received;	// symbols given to the decoder
+	int	incomplete;	// number of trials where decoding failed
+	int	corrupt;	// number of trials where a decoded symbol differs
+	long	peakRss;	// in KB
+	long	stack;		// in KB
+} bench_result;
+
+/* Results of one point of the grid, with -g */
+typedef struct {
+	double	legacyBuild;	// CreatePchkMatrix + mod2csr_from_sparse, in s
+	double	fastBuild;	// CreatePchkMatrixCompressed, in s
+	int	different;	// number of trials where the matrices differ
+	double	decInit;	// decoder InitSession + EndSession, in s
+	double	decReset;	// decoder ResetSession, in s
+} setup_result;
+
+/* Prototypes */
+double	now( void );
+long	procStatus( const char* );
+void	resetPeakRss( void );
+void	randomizeArray( int*, int );
+int	parseList( char*, double*, int );
+const char*	typeName( SessionType );
+int	benchPoint( SessionType, int, int, int, int, bool, int, bool, bool, int, bench_result* );
+int	benchSetup( SessionType, int, int, int, setup_result* );
+bool	sameMatrix( mod2csr*, mod2csr* );
+
+
+int main(int argc, char* argv[])
+{
+	int	defaultK[] = { 1000, 10000, 100000, 1000000 };
+	SessionType	types[MAX_VALUES] = { TypeSTAIRS };
+	double	ratios[MAX_VALUES] = { 1.5 };
+	double	sizes[MAX_VALUES] = { 64 };
+	int	ks[MAX_VALUES];
+	int	nbTypes = 1, nbRatios = 1, nbSizes = 1, nbK = 0;
+	int	trials = 1;
+	int	length = 0;	// whole symbol
+	bool	ml = false;
+	bool	owned = false;
+	bool	block = false;
+	int	matrixFlags = 0;	// FLAG_NO4CYCLE, FLAG_PEG
+	int	threads = -1;	// no EncodeBlockParallel
+	bool	json = false;
+	bool	setup = false;
+	bool	first = true;
+	bool	corrupt = false;	// in any point
+	char	*tok;
+	int	opt, t, r, s, i, trial;
+
+	while ((opt = getopt(argc, argv, "t:r:s:l:n:bp:moc:gj")) != -1) {
+		switch (opt) {
+		case 't':
+			nbTypes = 0;
+			for (tok = strtok(optarg, ","); tok != NULL && nbTypes < MAX_VALUES; tok = strtok(NULL, ",")) {
+				if (strcmp(tok, "ldgm") == 0)
+					types[nbTypes++] = TypeLDGM;
+				else if (strcmp(tok, "triangle") == 0)
+					types[nbTypes++] = TypeTRIANGLE;
+				else if (strcmp(tok, "qcstairs") == 0)
+					types[nbTypes++] = TypeQCSTAIRS;
+				else
+					types[nbTypes++] = TypeSTAIRS;
+			}
+			break;
+		case 'r':
+			nbRatios = parseList(optarg, ratios, MAX_VALUES);
+			break;
+		case 's':
+			nbSizes = parseList(optarg, sizes, MAX_VALUES);
+			break;
+		case 'l':
+			length = atoi(optarg);
+			break;
+		case 'n':
+			trials = atoi(optarg);
+			break;
+		case 'b':
+			block = true;
+			break;
+		case 'p':
+			threads = atoi(optarg);
+			break;
+		case 'm':
+			ml = true;
+			break;
+		case 'o':
+			owned = true;
+			break;
+		case 'c':
+			for (tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+				if (strcmp(tok, "no4cycle") == 0)
+					matrixFlags |= FLAG_NO4CYCLE;
+				else if (strcmp(tok, "peg") == 0)
+					matrixFlags |= FLAG_PEG;
+			}
+			break;
+		case 'g':
+			setup = true;
+			break;
+		case 'j':
+			json = true;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-t type[,type...]] [-r ratio[,ratio...]] [-s size[,size...]] [-l length] [-n trials] [-b] [-p threads] [-m] [-o] [-c construction[,construction]] [-g] [-j] [k ...]\n", argv[0]);
+			return -1;
+		}
+	}
+	if (nbTypes == 0 || nbRatios == 0 || nbSizes == 0 || trials < 1) {
+		fprintf(stderr, "Error: empty grid\n");
+		return -1;
+	}
+	for (i = optind; i < argc && nbK < MAX_VALUES; i++)
+		ks[nbK++] = atoi(argv[i]);
+	if (nbK == 0) {
+		for (i = 0; i < (int)(sizeof(defaultK)/sizeof(defaultK[0])); i++)
+			ks[nbK++] = defaultK[i];
+	}
+
+	if (json)
+		printf("[\n");
+	else if (setup)
+		printf("%-8s %8s %5s %6s %11s %11s %8s %9s %11s %11s\n",
+			"type", "k", "ratio", "size", "legacy(s)", "fast(s)", "speedup",
+			"identical", "decInit(s)", "decReset(s)");
+	else
+		printf("%-8s %8s %5s %6s %9s %9s %11s %9s %9s %11s %8s %11s %9s\n",
+			"type", "k", "ratio", "size", "encInit", "encMB/s", "encSym/s",
+			"decInit", "decMB/s", "decSym/s", "overhead", "peakRSS(KB)", "stack(KB)");
+	for (t = 0; t < nbTypes; t++) {
+		for (i = 0; i < nbK; i++) {
+			for (r = 0; r < nbRatios; r++) {
+				for (s = 0; s < nbSizes; s++) {
+					int		k = ks[i];
+					int		nbFec = (int)(k * (ratios[r] - 1.0));
+					int		size = (int)sizes[s];
+					int		payload = (length > 0 && length < size) ? length : size;
+					double		srcMB = (double)k * payload / 1e6;
+					bench_result	res;
+					setup_result	sres;
+
+					if (setup) {
+						memset(&sres, 0, sizeof(sres));
+						for (trial = 0; trial < trials; trial++) {
+							if (benchSetup(types[t], k, nbFec, size, &sres) < 0)
+								return -1;
+						}
+						sres.legacyBuild /= trials;
+						sres.fastBuild /= trials;
+						sres.decInit /= trials;
+						sres.decReset /= trials;
+						if (json) {
+							printf("%s  {\"type\": \"%s\", \"k\": %d, \"fec_ratio\": %g, \"symbol_size\": %d, "
+								"\"trials\": %d, \"legacy_build_s\": %.6f, \"fast_build_s\": %.6f, "
+								"\"identical\": %s, \"dec_init_s\": %.6f, \"dec_reset_s\": %.6f}",
+								first ? "" : ",\n", typeName(types[t]), k, ratios[r], size, trials,
+								sres.legacyBuild, sres.fastBuild, sres.different ? "false" : "true",
+								sres.decInit, sres.decReset);
+							first = false;
+						} else {
+							printf("%-8s %8d %5.2f %6d %11.4f %11.4f %8.1f %9s %11.6f %11.6f\n",
+								typeName(types[t]), k, ratios[r], size,
+								sres.legacyBuild, sres.fastBuild, sres.legacyBuild / sres.fastBuild,
+								sres.different ? "no" : "yes", sres.decInit, sres.decReset);
+						}
+						fflush(stdout);
+						continue;
+					}
+					if (types[t] == TypeQCSTAIRS && matrixFlags != 0) {
+						fprintf(stderr, "Skipped: %s k=%d, -c does not apply to quasi-cyclic codes\n",
+							typeName(types[t]), k);
+						continue;
+					}
+					memset(&res, 0, sizeof(res));
+					for (trial = 0; trial < trials; trial++) {
+						if (benchPoint(types[t], k, nbFec, size, payload, block, threads, ml, owned, matrixFlags, &res) < 0)
+							return -1;
+					}
+					res.encInit /= trials;
+					res.encTime /= trials;
+					res.decInit /= trials;
+					res.decTime /= trials;
+					res.received /= trials;
+					if (json) {
+						printf("%s  {\"type\": \"%s\", \"k\": %d, \"fec_ratio\": %g, \"symbol_size\": %d, "
+							"\"block\": %s, \"threads\": %d, \"ml\": %s, \"owned\": %s, "
+							"\"no4cycle\": %s, \"peg\": %s, \"trials\": %d, "
+							"\"enc_init_s\": %.6f, \"enc_mbps\": %.2f, \"enc_symbols_per_s\": %.0f, "
+							"\"dec_init_s\": %.6f, \"dec_mbps\": %.2f, \"dec_symbols_per_s\": %.0f, "
+							"\"overhead\": %.4f, \"incomplete\": %d, \"corrupt\": %d, "
+							"\"peak_rss_kb\": %ld, \"stack_kb\": %ld}",
+							first ? "" : ",\n", typeName(types[t]), k, ratios[r], size,
+							block ? "true" : "false", threads, ml ? "true" : "false",
+							owned ? "true" : "false",
+							(matrixFlags & FLAG_NO4CYCLE) ? "true" : "false",
+							(matrixFlags & FLAG_PEG) ? "true" : "false", trials,
+							res.encInit, srcMB / res.encTime, (k + nbFec) / res.encTime,
+							res.decInit, srcMB / res.decTime, res.received / res.decTime,
+							res.received / k, res.incomplete, res.corrupt, res.peakRss, res.stack);
+						first = false;
+					} else {
+						printf("%-8s %8d %5.2f %6d %9.4f %9.1f %11.0f %9.4f %9.1f %11.0f %8.4f %11ld %9ld%s",
+							typeName(types[t]), k, ratios[r], size,
+							res.encInit, srcMB / res.encTime, (k + nbFec) / res.encTime,
+							res.decInit, srcMB / res.decTime, res.received / res.decTime,
+							res.received / k, res.peakRss, res.stack,
+							res.incomplete ? "  (incomplete)" : "");
+						if (res.corrupt)
+							printf("  (%d corrupt)", res.corrupt);
+						printf("\n");
+					}
+					if (res.corrupt) {
+						fprintf(stderr, "Error: %s k=%d: %d trial(s) decoded corrupt symbols\n",
+							typeName(types[t]), k, res.corrupt);
+						corrupt = true;
+					}
+					fflush(stdout);
+				}
+			}
+		}
+	}
+	if (json)
+		printf("\n]\n");
+	return corrupt ? -1 : 0;
+}
+
+
+/*
+ * Encodes then decodes one block, and accumulates the results in res.
+ */
+int benchPoint( SessionType type, int k, int nbFec, int symbolSize, int payload, bool block, int threads, bool ml, bool owned, int matrixFlags, bench_result* res )
+{
+	LDPCFecSession	coder, decoder;
+	int	n = k + nbFec;
+	int	size = symbolSize;
+	int	length = payload;
+	char**	packetsArray = NULL;
+	unsigned int*	lengths = NULL;
+	void**	canvas = NULL;
+	int*	order = NULL;
+	int	i, j, received;
+	void*	buffer;
+	unsigned int	decoded;	// length of a decoded symbol
+	ldpc_error_status	status = LDPC_OK;
+	long	rssBefore, stackBefore;
+	double	t0, t1, t2;
+	int	ret = -1;
+
+	memset(&coder, 0, sizeof(coder));
+	memset(&decoder, 0, sizeof(decoder));
+	packetsArray = (char**)calloc(n, sizeof(char*));
+	canvas = (void**)calloc(n, sizeof(void*));
+	order = (int*)malloc(n * sizeof(int));
+	lengths = (unsigned int*)malloc(n * sizeof(unsigned int));
+	if (packetsArray == NULL || canvas == NULL || order == NULL || lengths == NULL) {
+		printf("Error: insufficient memory\n");
+		goto cleanup;
+	}
+	for (i = 0; i < n; i++) {
+		packetsArray[i] = (char*)calloc(1, size);
+		if (packetsArray[i] == NULL) {
+			printf("Error: insufficient memory\n");
+			goto cleanup;
+		}
+		lengths[i] = (i < k) ? length : 0;
+		if (i < k) {
+			for (j = 0; j < length; j++)
+				packetsArray[i][j] = (char)rand();
+		}
+	}
+
+	// Encoding, the matrix being built (not taken from the cache)
+	pchk_cache_purge();
+	t0 = now();
+	if (InitSession(&coder, k, nbFec, size, FLAG_CODER | matrixFlags, SEED, type, LEFT_DEGREE) == LDPC_ERROR) {
+		printf("Error: Unable to initialize LDPC Session\n");
+		goto cleanup;
+	}
+	t1 = now();
+	if (threads >= 0) {
+		status = EncodeBlockParallel(&coder, (void**)packetsArray, lengths, threads, NULL, NULL);
+	} else if (block) {
+		status = EncodeBlock(&coder, (void**)packetsArray, lengths);
+	} else {
+		for (i = 0; i < nbFec && status == LDPC_OK; i++) {
+			status = BuildParitySymbol(&coder, (void**)packetsArray, lengths, i, packetsArray[k + i]);
+		}
+	}
+	t2 = now();
+	if (status != LDPC_OK) {
+		printf("Error: Unable to encode the block\n");
+		goto cleanup;
+	}
+	res->encInit += t1 - t0;
+	res->encTime += t2 - t1;
+
+	// Decoding, symbols being received in random order
+	randomizeArray(order, n);
+	resetPeakRss();
+	rssBefore = procStatus("VmRSS:");
+	stackBefore = procStatus("VmStk:");
+	t0 = now();
+	if (InitSession(&decoder, k, nbFec, size, FLAG_DECODER | matrixFlags, SEED, type, LEFT_DEGREE) == LDPC_ERROR) {
+		printf("Error: Unable to initialize LDPC Session\n");
+		goto cleanup;
+	}
+	SetMLDecoding(&decoder, ml);
+	t1 = now();
+	for (received = 0; received < n && !IsDecodingComplete(&decoder, canvas); received++) {
+		if (owned) {
+			if ((buffer = AllocSymbol(&decoder)) == NULL) {
+				printf("Error: insufficient memory\n");
+				goto cleanup;
+			}
+			memcpy(buffer, packetsArray[order[received]], lengths[order[received]]);
+			status = DecodingWithOwnedSymbol(&decoder, canvas, buffer, order[received],
+					lengths[order[received]]);
+		} else {
+			status = DecodingWithSymbol(&decoder, canvas, packetsArray[order[received]], order[received],
+					lengths[order[received]], false);
+		}
+		if (status != LDPC_OK) {
+			printf("Error: Unable to decode symbol %d\n", order[received]);
+			goto cleanup;
+		}
+	}
+	t2 = now();
+	res->decInit += t1 - t0;
+	res->decTime += t2 - t1;
+	res->received += received;
+	if (!IsDecodingComplete(&decoder, canvas))
+		res->incomplete++;
+	// decoded symbols against the original ones, zero past their length
+	for (i = 0; i < k; i++) {
+		if (canvas[i] == NULL)
+			continue;
+		decoded = GetSymbolLength(&decoder, i);
+		if (decoded > (unsigned int)size || memcmp(canvas[i], packetsArray[i], decoded) != 0)
+			break;
+		for (j = decoded; j < size && packetsArray[i][j] == 0; j++)
+			;
+		if (j < size)
+			break;
+	}
+	if (i < k)
+		res->corrupt++;
+	if (procStatus("VmHWM:") - rssBefore > res->peakRss)
+		res->peakRss = procStatus("VmHWM:") - rssBefore;
+	if (procStatus("VmStk:") - stackBefore > res->stack)
+		res->stack = procStatus("VmStk:") - stackBefore;
+	ret = 0;
+
+cleanup:
+	if (IsInitialized(&decoder))
+		EndSession(&decoder);
+	if (IsInitialized(&coder))
+		EndSession(&coder);
+	for (i = 0; packetsArray != NULL && i < n; i++) {
+		free(packetsArray[i]);
+	}
+	free(packetsArray);
+	free(lengths);
+	free(canvas);
+	free(order);
+	return ret;
+}
+
+
+/*
+ * Measures the setup costs of one block, and accumulates them in res.
+ */
+int benchSetup( SessionType type, int k, int nbFec, int symbolSize, setup_result* res )
+{
+	LDPCFecSession	decoder;
+	ldpc_prng	prng;
+	mod2sparse*	sparse = NULL;
+	mod2csr*	legacy = NULL;
+	mod2csr*	fast = NULL;
+	void**	canvas = NULL;
+	char*	symbol = NULL;
+	int*	order = NULL;
+	int	n = k + nbFec;
+	int	i;
+	double	t0, t1;
+	int	ret = -1;
+
+	memset(&decoder, 0, sizeof(decoder));
+	canvas = (void**)calloc(n, sizeof(void*));
+	symbol = (char*)calloc(1, symbolSize);
+	order = (int*)malloc(n * sizeof(int));
+	if (canvas == NULL || symbol == NULL || order == NULL) {
+		printf("Error: insufficient memory\n");
+		goto cleanup;
+	}
+
+	// Parity check matrix, as built before and now
+	ldpc_srand(&prng, SEED);
+	t0 = now();
+	if ((sparse = CreatePchkMatrix(nbFec, n, Evenboth, LEFT_DEGREE, &prng, false, type)) == NULL ||
+			(legacy = mod2csr_from_sparse(sparse)) == NULL) {
+		printf("Error: Unable to create the parity check matrix\n");
+		goto cleanup;
+	}
+	t1 = now();
+	res->legacyBuild += t1 - t0;
+	ldpc_srand(&prng, SEED);
+	t0 = now();
+	if ((fast = CreatePchkMatrixCompressed(nbFec, n, Evenboth, LEFT_DEGREE, &prng, false, type)) == NULL) {
+		printf("Error: Unable to create the parity check matrix\n");
+		goto cleanup;
+	}
+	t1 = now();
+	res->fastBuild += t1 - t0;
+	if (!sameMatrix(legacy, fast))
+		res->different++;
+
+	// Decoder set up, the matrix being in the cache
+	if (InitSession(&decoder, k, nbFec, symbolSize, FLAG_DECODER, SEED, type, LEFT_DEGREE) == LDPC_ERROR) {
+		printf("Error: Unable to initialize LDPC Session\n");
+		goto cleanup;
+	}
+	EndSession(&decoder);
+	t0 = now();
+	if (InitSession(&decoder, k, nbFec, symbolSize, FLAG_DECODER, SEED, type, LEFT_DEGREE) == LDPC_ERROR) {
+		printf("Error: Unable to initialize LDPC Session\n");
+		goto cleanup;
+	}
+	EndSession(&decoder);
+	t1 = now();
+	res->decInit += t1 - t0;
+
+	// Decoder recycled after a block (all-zero symbols)
+	if (InitSession(&decoder, k, nbFec, symbolSize, FLAG_DECODER, SEED, type, LEFT_DEGREE) == LDPC_ERROR) {
+		printf("Error: Unable to initialize LDPC Session\n");
+		goto cleanup;
+	}
+	randomizeArray(order, n);
+	for (i = 0; i < n && !IsDecodingComplete(&decoder, canvas); i++) {
+		DecodingWithSymbol(&decoder, canvas, symbol, order[i], symbolSize, false);
+	}
+	t0 = now();
+	if (ResetSession(&decoder) == LDPC_ERROR) {
+		printf("Error: Unable to reset LDPC Session\n");
+		goto cleanup;
+	}
+	t1 = now();
+	res->decReset += t1 - t0;
+	ret = 0;
+
+cleanup:
+	if (IsInitialized(&decoder))
+		EndSession(&decoder);
+	if (sparse != NULL) {
+		mod2sparse_free(sparse);
+		free(sparse);
+	}
+	mod2csr_free(legacy);
+	mod2csr_free(fast);
+	free(canvas);
+	free(symbol);
+	free(order);
+	return ret;
+}
+
+
+/* True if two compressed matrices are the same */
+bool sameMatrix( mod2csr* a, mod2csr* b )
+{
+	if (a->n_rows != b->n_rows || a->n_cols != b->n_cols || a->nnz != b->nnz ||
+			a->idx_size != b->idx_size)
+		return false;
+	return memcmp(a->row_ptr, b->row_ptr, (a->n_rows + 1) * sizeof(INT32)) == 0 &&
+		memcmp(a->col_ptr, b->col_ptr, (a->n_cols + 1) * sizeof(INT32)) == 0 &&
+		memcmp(a->col_idx, b->col_idx, (size_t)a->nnz * a->idx_size) == 0 &&
+		memcmp(a->row_idx, b->row_idx, (size_t)a->nnz * a->idx_size) == 0;
+}
+
+
+/* Parses a comma separated list of numbers, returns the number of values */
+int parseList( char* str, double* values, int maxValues )
+{
+	char	*tok;
+	int	nb = 0;
+
+	for (tok = strtok(str, ","); tok != NULL && nb < maxValues; tok = strtok(NULL, ","))
+		values[nb++] = atof(tok);
+	return nb;
+}
+
+/* Name of a session type, as given to -t */
+const char* typeName( SessionType type )
+{
+	switch (type) {
+	case TypeLDGM:		return "ldgm";
+	case TypeTRIANGLE:	return "triangle";
+	case TypeQCSTAIRS:	return "qcstairs";
+	default:		return "stairs";
+	}
+}
+
+/* Current time, in seconds */
+double now( void )
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Value (in kB) of a field of /proc/self/status, or -1 */
+long procStatus( const char* field )
+{
+	FILE	*f;
+	char	line[256];
+	long	val = -1;
+
+	if ((f = fopen("/proc/self/status", "r")) == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (strncmp(line, field, strlen(field)) == 0) {
+			val = atol(line + strlen(field));
+			break;
+		}
+	}
+	fclose(f);
+	return val;
+}
+
+/* Resets VmHWM (peak RSS) to the current RSS */
+void resetPeakRss( void )
+{
+	FILE	*f;
+
+	if ((f = fopen("/proc/self/clear_refs", "w")) != NULL) {
+		fputs("5", f);
+		fclose(f);
+	}
+}
+
+/* Randomize an array of integers */
+void randomizeArray( int* array, int arrayLen )
+{
+	int	backup, randInd, i;
+
+	for (i = 0; i < arrayLen; i++)
+		array[i] = i;
+	for (i = arrayLen - 1; i > 0; i--) {
+		randInd = rand() % (i + 1);
+		backup = array[i];
+		array[i] = array[randInd];
+		array[randInd] = backup;
+	}
+}
@@ -0,0 +1,116 @@
+/*
+ * Generates parity check matrix files.
+ * For each (k, n) pair given, the matrix used by the sessions created with
+ * these parameters is built and saved in a directory of matrix files,
+ * under the name searched by the matrix cache (see
+ * pchk_cache_set_directory): sessions then map it instead of building it.
+ * The file is mapped back and compared with the matrix built.
+ *
+ * Usage: ldpc_mkpchk [-t type] [-m method] [-c] [-d degree] [-s seed] [-o dir] k n [k n ...]
+ *	-t	session type among ldgm, stairs, triangle and qcstairs
+ *		(default stairs)
+ *	-m	construction among evenboth and peg (default evenboth), i.e.
+ *		sessions without or with FLAG_PEG
+ *	-c	without 4-cycles, i.e. for sessions with FLAG_NO4CYCLE
+ *	-d	left degree (default 3)
+ *	-s	seed (default 2003)
+ *	-o	directory of matrix files (default .)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/ldpc_fec.h"
+#include "../src/ldpc_pchk_file.h"
+
+#define SEED		2003	// Seed used to initialize LDPCFecSession
+#define LEFT_DEGREE	3	// Left degree of data nodes in the checks graph
+
+
+int main(int argc, char* argv[])
+{
+	SessionType	type = TypeSTAIRS;
+	make_method	method = Evenboth;
+	bool	no4cycle = false;
+	int	leftDegree = LEFT_DEGREE;
+	int	seed = SEED;
+	const char	*dir = ".";
+	char	path[PCHK_FILE_PATH_MAX];
+	ldpc_prng	prng;
+	mod2csr	*matrix, *mapped;
+	int	opt, i, k, n;
+	bool	same;
+
+	while ((opt = getopt(argc, argv, "t:m:cd:s:o:")) != -1) {
+		switch (opt) {
+		case 't':
+			if (strcmp(optarg, "ldgm") == 0)
+				type = TypeLDGM;
+			else if (strcmp(optarg, "triangle") == 0)
+				type = TypeTRIANGLE;
+			else if (strcmp(optarg, "qcstairs") == 0)
+				type = TypeQCSTAIRS;
+			else
+				type = TypeSTAIRS;
+			break;
+		case 'm':
+			method = (strcmp(optarg, "peg") == 0) ? PEG : Evenboth;
+			break;
+		case 'c':
+			no4cycle = true;
+			break;
+		case 'd':
+			leftDegree = atoi(optarg);
+			break;
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case 'o':
+			dir = optarg;
+			break;
+		default:
+			optind = argc;	// usage
+			break;
+		}
+	}
+	if (optind >= argc || (argc - optind) % 2 != 0) {
+		fprintf(stderr, "Usage: %s [-t type] [-m method] [-c] [-d degree] [-s seed] [-o dir] k n [k n ...]\n", argv[0]);
+		return -1;
+	}
+
+	for (i = optind; i < argc; i += 2) {
+		k = atoi(argv[i]);
+		n = atoi(argv[i + 1]);
+		if (k <= 0 || n <= k) {
+			fprintf(stderr, "Error: invalid k=%d n=%d\n", k, n);
+			return -1;
+		}
+		if (!ldpc_srand(&prng, seed) ||
+				(matrix = CreatePchkMatrixCompressed(n - k, n, method, leftDegree, &prng, no4cycle, type)) == NULL) {
+			fprintf(stderr, "Error: Unable to create the parity check matrix (k=%d n=%d)\n", k, n);
+			return -1;
+		}
+		if (pchk_file_name(path, sizeof(path), dir, n - k, n, method, leftDegree, seed, no4cycle, type) < 0 ||
+				pchk_file_write(path, matrix, method, leftDegree, seed, no4cycle, type) < 0) {
+			mod2csr_free(matrix);
+			return -1;
+		}
+
+		// check what the sessions will get
+		mapped = pchk_file_find(dir, n - k, n, method, leftDegree, seed, no4cycle, type);
+		same = mapped != NULL && mapped->nnz == matrix->nnz &&
+			memcmp(mapped->row_ptr, matrix->row_ptr, (matrix->n_rows + 1) * sizeof(INT32)) == 0 &&
+			memcmp(mapped->col_ptr, matrix->col_ptr, (matrix->n_cols + 1) * sizeof(INT32)) == 0 &&
+			memcmp(mapped->col_idx, matrix->col_idx, (size_t)matrix->nnz * matrix->idx_size) == 0 &&
+			memcmp(mapped->row_idx, matrix->row_idx, (size_t)matrix->nnz * matrix->idx_size) == 0;
+		mod2csr_free(mapped);
+		mod2csr_free(matrix);
+		if (!same) {
+			fprintf(stderr, "Error: %s does not hold the matrix built\n", path);
+			return -1;
+		}
+		printf("%s\n", path);
+	}
+	return 0;
+}
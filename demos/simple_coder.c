@@ -19,22 +19,30 @@ int main(int argc, char* argv[])
 	int	data_size;
 	LDPC_head data_head;
 	char **all_data[GROUP];
+	unsigned int *all_lengths[GROUP];
+	unsigned int *lengths	= NULL;
+	char	packet[sizeof(LDPC_head) + SYMSZ];
 	LDPCFecSession Session[GROUP];
 
 	mtrace();
+	memset(all_data, 0, sizeof(all_data));
+	memset(all_lengths, 0, sizeof(all_lengths));
 
 	for(j=0; j<GROUP; j++)
 	{
 		memset(&Session[j], 0, sizeof(Session[i]));
 
 		// Initialize the LDPC session
-		if(InitSession(&Session[j], NBDATA, NBFEC, PKTSZ+sizeof(LDPC_head), FLAG_CODER, SEED, SESSION_TYPE, LEFT_DEGREE ) == LDPC_ERROR)
+		if(InitSession(&Session[j], NBDATA, NBFEC, SYMSZ, FLAG_CODER, SEED, SESSION_TYPE, LEFT_DEGREE ) == LDPC_ERROR)
 		{
 			printf("Error: Unable to initialize LDPC Session\n");
 			ret = -1; goto cleanup;
 		}
 		packetsArray = (char**)calloc( NBPKT, sizeof(char*) );
-		if( packetsArray == NULL ) {
+		lengths = (unsigned int*)calloc( NBPKT, sizeof(unsigned int) );
+		all_data[j] = packetsArray;
+		all_lengths[j] = lengths;
+		if( packetsArray == NULL || lengths == NULL ) {
 			printf("Error: insufficient memory (calloc failed for packetsArray)\n");
 			ret = -1; goto cleanup;
 		}
@@ -42,23 +50,17 @@ int main(int argc, char* argv[])
 		srand((unsigned int)time(NULL));
 		for( i=0; i<NBDATA; i++ )
 		{	// First packet filled with 0x1111..., second with 0x2222..., etc.
-			data_size = PKTSZ - (rand()%10)+sizeof(LDPC_head);
-			packetsArray[i] = (char*) malloc(data_size);
+			data_size = PKTSZ - (rand()%10);
+			// the symbol is only as long as its data
+			packetsArray[i] = (char*) malloc(LDPC_FRAME_SYMBOL_SIZE(data_size));
 			if( packetsArray[i] == NULL ) {
 				ret = -1; goto cleanup;
 			}
 			printf("data_size:%d\n", data_size);
-			data_head.type_flag 		= 	0;
-			data_head.group_id 			= 	j+1;
-			data_head.total_data 		= 	(unsigned short)NBDATA;
-			data_head.total_fec 		= 	(unsigned short)NBFEC;
-			data_head.sequence_no 		= 	(unsigned int)i;
-			data_head.current_length	= 	(unsigned short)data_size;
-			data_head.longest_length 	= 	(unsigned short)(PKTSZ + sizeof(LDPC_head));
-			memcpy(packetsArray[i], &data_head, sizeof(data_head));
-			memset( packetsArray[i]+sizeof(data_head), (char)(i+((j+1)<<4)), data_size-sizeof(data_head));
+			memset( LDPC_FRAME_DATA(packetsArray[i]), (char)(i+((j+1)<<4)), data_size);
+			lengths[i] = ldpc_frame_set_data_length(packetsArray[i], data_size);
 			printf( "DATA[%03d]= \n", i );
-			DumpBuffer( packetsArray[i], data_size );
+			DumpBuffer( (char*)LDPC_FRAME_DATA(packetsArray[i]), data_size );
 		}
 
 		// Now creating some FEC Packets...
@@ -66,25 +68,15 @@ int main(int argc, char* argv[])
 
 		for( i=0; i < NBFEC; i++ )
 		{
-			packetsArray[i+NBDATA] = (char*)malloc(PKTSZ+sizeof(data_head));
+			packetsArray[i+NBDATA] = (char*)malloc(SYMSZ);
 			if( packetsArray[i+NBDATA] == NULL ) {
 				ret = -1; 
 				goto cleanup;
 			}
-			data_head.type_flag 		= 	1;
-			data_head.group_id 			= 	j+1;
-			data_head.total_data 		= 	(unsigned short)NBDATA;
-			data_head.total_fec 		= 	(unsigned short)NBFEC;
-			data_head.sequence_no 		= 	(unsigned int)(i+NBDATA);
-			data_head.current_length	= 	0;
-			data_head.longest_length 	= 	(unsigned short)(PKTSZ + sizeof(LDPC_head));
-			memcpy(packetsArray[i+NBDATA], &data_head, sizeof(data_head));
-			memset( packetsArray[i+NBDATA]+sizeof(data_head), 0, PKTSZ);
-			BuildParitySymbol(&Session[j],  (void**)packetsArray, i, packetsArray[i+NBDATA] );
+			BuildParitySymbol(&Session[j],  (void**)packetsArray, lengths, i, packetsArray[i+NBDATA] );
 			//printf( "DATA[%03d]= \n", i+NBDATA );
-			//DumpBuffer( packetsArray[i+NBDATA], PKTSZ+sizeof(data_head) );  // dump packet to screen
+			//DumpBuffer( packetsArray[i+NBDATA], lengths[i+NBDATA] );  // dump symbol to screen
 		}
-		all_data[j]=packetsArray;
 	}
 
 	// Randomize packets order...
@@ -117,14 +109,17 @@ int main(int argc, char* argv[])
 			if(i%NBDROP == 1)
 				continue;
 
-			memcpy(&data_head, all_data[randOrder2[j]][randOrder1[i]], sizeof(data_head));
-			if(data_head.type_flag)
-				data_size = data_head.longest_length;
-			else
-				data_size = data_head.current_length;
+			data_head.type_flag 		= 	(randOrder1[i] >= NBDATA);
+			data_head.group_id 			= 	randOrder2[j]+1;
+			data_head.total_data 		= 	(unsigned short)NBDATA;
+			data_head.total_fec 		= 	(unsigned short)NBFEC;
+			data_head.sequence_no 		= 	(unsigned int)randOrder1[i];
+			data_head.longest_length 	= 	(unsigned short)(SYMSZ + sizeof(LDPC_head));
+			data_size = ldpc_frame_write(packet, sizeof(packet), &data_head,
+					all_data[randOrder2[j]][randOrder1[i]], all_lengths[randOrder2[j]][randOrder1[i]]);
 
 			//printf("Sending packet %-5d %-5d (%s)\n", randOrder2[j], randOrder1[i], randOrder1[i]<NBDATA ? "DATA" : "FEC");
-			ret = sendto(mySock, all_data[randOrder2[j]][randOrder1[i]], data_size, 0, (struct sockaddr *)&destHost, sizeof(destHost));
+			ret = sendto(mySock, packet, data_size, 0, (struct sockaddr *)&destHost, sizeof(destHost));
 			if (ret == SOCKET_ERROR) {
 				printf( "main: Error! sendto() failed!\n" );
 				ret = -1;
@@ -159,6 +154,7 @@ cleanup:
 			}
 			free(packetsArray);
 		}
+		free(all_lengths[j]);
 	}
 
 	// Bye bye! :-)
@@ -7,6 +7,7 @@
 
 #include "../src/ldpc_fec.h"
 #include "../src/ldpc_group.h"
+#include "../src/ldpc_framing.h"
 
 /*
  * OS dependant definitions
@@ -24,11 +25,16 @@
  */
 #define GROUP 	5
 #define PKTSZ	1024		// Packets size, in bytes (multiple of 4).
+#define SYMSZ	LDPC_FRAME_SYMBOL_SIZE(PKTSZ)	// Symbol size, in bytes.
 #define NBDATA	10		// Number of original DATA packets to send.
 #define NBFEC	10		// Number of FEC packets to build.
 #define NBDROP	3		// NBPKT/NBDROP is Drop percent.
 #define NBPKT	(NBDATA+NBFEC)	// Total number of packets to send.
 #define LEFT_DEGREE	3	// Left degree of data nodes in the checks graph
+#define GROUP_IDLE_TIMEOUT	2000	// Receiver: evict a group after 2s without packets
+#define GROUP_DEADLINE		10000	// Receiver: or 10s after its first packet
+#define GROUP_SPARES		4	// Receiver: decoded groups kept for reuse
+#define PCHK_DIR_ENV	"LDPC_PCHK_DIR"	// Receiver: directory of matrix files
 
 /*
  * The Session Type.
@@ -2,17 +2,23 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <mcheck.h>
+#include <time.h>
 #include "simple_coder.h"
 
 /* Prototypes */
 SOCKET initSocket( );
 void DumpBuffer( char*, int );
+unsigned long GetTimeMs( );
+void EvictGroup( void*, LDPC_group_list*, group_evict_reason );
+void DumpGroup( LDPC_group_list* );
 
 int main(int argc, char* argv[])
 {
-	int i, data_size;
+	int data_size;
 	char is_new=0;
-	LDPC_group_list *group_list=NULL, *group_head=NULL;
+	unsigned int pos;
+	LDPC_group_list *group_list=NULL;
+	LDPC_group_table *group_table=NULL;
 
 	// Received (and rebuilt) packets (DATA and FEC) are stored in a 
 	// packets array where each packet is an array of bytes (char).
@@ -24,6 +30,8 @@ int main(int argc, char* argv[])
 	int	decodeSteps = 0;
 	int 	total = 0;
 	LDPC_head data_head;
+	void*	symbol;
+	unsigned int	symbol_length;
 
 	struct timeval timeout;
 	fd_set readfds;
@@ -40,94 +48,75 @@ int main(int argc, char* argv[])
 		goto cleanup;
 	}
 
-	buff	= (char*) malloc(PKTSZ+sizeof(LDPC_head));
+	buff	= (char*) malloc(sizeof(LDPC_head)+SYMSZ);
 	if ( buff==NULL) {
 		printf("Error: insufficient memory (calloc failed in main())\n");
 		ret = -1; goto cleanup;
 	}
 
+	// Matrices generated beforehand by ldpc_mkpchk, if any
+	if(getenv(PCHK_DIR_ENV) != NULL)
+		pchk_cache_set_directory(getenv(PCHK_DIR_ENV));
+
+	// Incomplete groups are evicted after a timeout
+	group_table = group_table_init(0);
+	if(NULL == group_table)
+	{
+		ret = -1;
+		goto cleanup;
+	}
+	group_table_set_timeouts(group_table, GROUP_IDLE_TIMEOUT, GROUP_DEADLINE, EvictGroup, NULL);
+	// all the groups use the same parameters: recycle their sessions
+	group_table_set_spares(group_table, GROUP_SPARES);
+	group_table_expire(group_table, GetTimeMs());
+
 	//printf( "Decoding in progress...\nWaiting for new packets...\n" );
 	while(1)
 	{
 		decodeSteps++;
+		group_table_expire(group_table, GetTimeMs());
 		FD_ZERO(&readfds);
 		FD_SET(mySock, &readfds);
 
 		if(select(mySock+1,&readfds,NULL, NULL, &timeout) > 0)
 		{
-			ret = recvfrom( mySock, buff, PKTSZ+sizeof(data_head), 0, NULL, NULL );
+			ret = recvfrom( mySock, buff, sizeof(LDPC_head)+SYMSZ, 0, NULL, NULL );
 			if(ret < 0)
 			{
 				ret = -1;
 				goto cleanup;	
 			}
 			// OK, new packet received...
-			memcpy(&data_head, buff, sizeof(data_head));
+			if(ldpc_frame_read(buff, ret, &data_head, &symbol, &symbol_length) < 0)
+			{
+				printf("bad packet (%d bytes) dropped\n", ret);
+				continue;
+			}
 			//printf("------------------------------------\n");
 			//printf("--- Step %d : new packet received: %02d, size:%d %d, group_id:%d, buffer:0x%x\n", decodeSteps, data_head.sequence_no, data_head.current_length, data_head.longest_length, data_head.group_id, buff);
-			if(NULL == group_head)
+			group_list = group_table_search(group_table, &is_new, data_head.group_id, data_head.total_data + data_head.total_fec);
+			if(NULL == group_list)
 			{
-				group_head = group_list_init(data_head.group_id, data_head.total_data + data_head.total_fec);
-				if(NULL == group_head)
-				{
-					ret = -1;
-					goto cleanup;
-				}
-
-				group_list = group_head;
+				ret = -1;
+				goto cleanup;
+			}
 
-				// Initialize the LDPC session
-				if(InitSession(group_list->Session, NBDATA, NBFEC, data_head.longest_length, FLAG_DECODER, SEED, SESSION_TYPE, LEFT_DEGREE ) == LDPC_ERROR)
+			if(is_new && !IsInitialized(group_list->Session))
+			{
+				// Initialize the LDPC session (a recycled one is
+				// ready for the new group)
+				if(InitSession(group_list->Session, NBDATA, NBFEC, data_head.longest_length - sizeof(LDPC_head), FLAG_DECODER, SEED, SESSION_TYPE, LEFT_DEGREE ) == LDPC_ERROR)
 				{
 					printf("Error: Unable to initialize LDPC Session\n");
 					ret = -1; goto cleanup;
 				}
-
-				DecodingWithSymbol(group_list->Session, (void**)(group_list->packet), buff, data_head.sequence_no, true);
-			}
-			else
-			{
-				group_list = group_list_search(group_head, &is_new, data_head.group_id, data_head.total_data + data_head.total_fec);
-				if(NULL == group_list)
-				{
-					ret = -1;
-					goto cleanup;
-				}
-
-				if(is_new)
-				{
-					// Initialize the LDPC session
-					if(InitSession(group_list->Session, NBDATA, NBFEC, data_head.longest_length, FLAG_DECODER, SEED, SESSION_TYPE, LEFT_DEGREE ) == LDPC_ERROR)
-					{
-						printf("Error: Unable to initialize LDPC Session\n");
-						ret = -1; goto cleanup;
-					}
-				}
-				DecodingWithSymbol(group_list->Session, (void**)(group_list->packet), buff, data_head.sequence_no, true);
 			}
+			DecodingWithSymbol(group_list->Session, (void**)(group_list->packet), symbol, data_head.sequence_no, symbol_length, true);
 			if(IsDecodingComplete(group_list->Session, (void**)(group_list->packet)))
 			{
-				printf("group:%d\n", group_list->group_id);
-				for(i=0;i<group_list->total_pkt;i++)
-				{
-					if(group_list->packet[i] == NULL)
-						continue;
-					memcpy(&data_head, group_list->packet[i], sizeof(data_head));
-					data_size = data_head.current_length;
-					printf("group_id:\t\t%d\ntotal_data:\t\t%d\ntotal_fec:\t\t%d\nsequence_no:\t\t%d\ncurrent_length:\t%d\nlongest_length:\t%d\n",
-							data_head.group_id,
-							data_head.total_data,
-							data_head.total_fec,
-							data_head.sequence_no,
-							data_head.current_length,
-							data_head.longest_length);
-					printf("size=%d, DATA[%d]= \n",data_size, i);
-					DumpBuffer(group_list->packet[i], data_size);
-					total++;
-				}
-				if( IsInitialized(group_list->Session) ) 
-					EndSession(group_list->Session);
-				group_list_delete(&group_head, group_list->group_id);
+				DumpGroup(group_list);
+				total += NBDATA;
+				group_table_delete(group_table, group_list->group_id);
 			}
 		}
 		else
@@ -138,29 +127,16 @@ int main(int argc, char* argv[])
 	printf("=======Above is wonderful packet decoder, next is decoder some packet and rest=================\n");
 	printf("===============================================================================================\n");
 
-	group_list = group_head;
+	pos = 0;
 	total=0;
-	while(group_list != NULL)
+	while(group_table != NULL && (group_list = group_table_next(group_table, &pos)) != NULL)
 	{
-		printf("group:%d\n", group_list->group_id);
-		for(i=0;i<group_list->total_pkt;i++)
+		DumpGroup(group_list);
+		for(data_size=0;data_size<NBDATA;data_size++)
 		{
-			if(group_list->packet[i] == NULL)
-				continue;
-			memcpy(&data_head, group_list->packet[i], sizeof(data_head));
-			data_size = data_head.current_length;
-			printf("group_id:\t\t%d\ntotal_data:\t\t%d\ntotal_fec:\t\t%d\nsequence_no:\t\t%d\ncurrent_length:\t%d\nlongest_length:\t%d\n",
-					data_head.group_id,
-					data_head.total_data,
-					data_head.total_fec,
-					data_head.sequence_no,
-					data_head.current_length,
-					data_head.longest_length);
-			printf("size=%d, DATA[%d]= \n",data_size, i);
-			DumpBuffer(group_list->packet[i], data_size);
-			total++;
+			if(group_list->packet[data_size] != NULL)
+				total++;
 		}
-		group_list = group_list->next;
 	}
 
 	printf("%d packets rebuilt\n", total);
@@ -169,13 +145,7 @@ int main(int argc, char* argv[])
 	// Cleanup...
 cleanup:
 	if( mySock!= INVALID_SOCKET ) closesocket(mySock);
-	group_list = group_head;
-	while(group_list != NULL){
-		if( IsInitialized(group_list->Session) ) 
-			EndSession(group_list->Session);
-		group_list = group_list->next;
-	}
-	group_list_deinit(group_head);
+	group_table_deinit(group_table);
 
 	if(buff) free(buff);
 
@@ -234,3 +204,46 @@ void DumpBuffer( char* buf, int len )
 	printf("\n");
 }
 
+/* Current (monotonic) time, in ms */
+unsigned long GetTimeMs( )
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Called for each group that could not be decoded in time */
+void EvictGroup( void* context, LDPC_group_list* group, group_evict_reason reason )
+{
+	printf("group:%d evicted (%s)\n", group->group_id,
+			(reason == GROUP_EVICT_DEADLINE) ? "deadline" : "idle");
+}
+
+/* Prints the source packets of a group received or rebuilt so far */
+void DumpGroup( LDPC_group_list* group )
+{
+	LDPCFecSession *Session = group->Session;
+	int i, data_size;
+
+	printf("group:%d\n", group->group_id);
+	for(i=0;i<Session->m_nbSourceSymbols;i++)
+	{
+		if(group->packet[i] == NULL)
+			continue;
+		data_size = ldpc_frame_get_data_length(group->packet[i], GetSymbolLength(Session, i), Session->m_symbolSize);
+		if(data_size < 0)
+		{
+			printf("DATA[%d]: bad length\n", i);
+			continue;
+		}
+		printf("group_id:\t\t%d\ntotal_data:\t\t%d\ntotal_fec:\t\t%d\nsequence_no:\t\t%d\ndata_length:\t%d\n",
+				group->group_id,
+				Session->m_nbSourceSymbols,
+				Session->m_nbParitySymbols,
+				i,
+				data_size);
+		printf("size=%d, DATA[%d]= \n",data_size, i);
+		DumpBuffer((char*)LDPC_FRAME_DATA(group->packet[i]), data_size);
+	}
+}
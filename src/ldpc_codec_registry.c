@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "ldpc_codec_registry.h"
+
+static pthread_mutex_t		registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static const ldpc_codec_profile	*registry[LDPC_CODEC_MAX];	// oldest first
+static int			registry_nb = 0;
+
+
+/******************************************************************************
+ * ldpc_codec_register: Registers a specialized encoder.
+ * => See header file for more informations.
+ */
+	int
+ldpc_codec_register	(const ldpc_codec_profile	*profile)
+{
+	int	i;
+
+	pthread_mutex_lock(&registry_lock);
+	for (i = 0; i < registry_nb && registry[i] != profile; i++)
+		;
+	if (i < registry_nb) {
+		// already there: it becomes the last one registered
+		for (; i + 1 < registry_nb; i++)
+			registry[i] = registry[i + 1];
+		registry_nb--;
+	} else if (registry_nb == LDPC_CODEC_MAX) {
+		pthread_mutex_unlock(&registry_lock);
+		fprintf(stderr, "ldpc_codec_register: ERROR, more than %d profiles\n", LDPC_CODEC_MAX);
+		return -1;
+	}
+	registry[registry_nb++] = profile;
+	pthread_mutex_unlock(&registry_lock);
+	return 0;
+}
+
+
+/******************************************************************************
+ * ldpc_codec_unregister: Unregisters a specialized encoder.
+ * => See header file for more informations.
+ */
+	void
+ldpc_codec_unregister	(const ldpc_codec_profile	*profile)
+{
+	int	i;
+
+	pthread_mutex_lock(&registry_lock);
+	for (i = 0; i < registry_nb && registry[i] != profile; i++)
+		;
+	if (i < registry_nb) {
+		for (; i + 1 < registry_nb; i++)
+			registry[i] = registry[i + 1];
+		registry_nb--;
+	}
+	pthread_mutex_unlock(&registry_lock);
+}
+
+
+/******************************************************************************
+ * ldpc_codec_find: Returns the specialized encoder for these parameters.
+ * => See header file for more informations.
+ */
+	const ldpc_codec_profile*
+ldpc_codec_find	(SessionType	type,
+		 int		nbSourceSymbols,
+		 int		nbParitySymbols,
+		 unsigned int	symbolSize,
+		 make_method	makeMethod,
+		 int		leftDegree,
+		 int		seed,
+		 bool		no4cycle)
+{
+	const ldpc_codec_profile	*p;
+	int				i;
+
+	pthread_mutex_lock(&registry_lock);
+	for (i = registry_nb - 1; i >= 0; i--) {
+		p = registry[i];
+		if (p->type == type && p->nbSourceSymbols == nbSourceSymbols &&
+				p->nbParitySymbols == nbParitySymbols &&
+				p->symbolSize == symbolSize &&
+				p->makeMethod == makeMethod &&
+				p->leftDegree == leftDegree &&
+				p->seed == seed && p->no4cycle == no4cycle) {
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_lock);
+	return (i >= 0) ? p : NULL;
+}
+
+
+/******************************************************************************
+ * ldpc_codec_hash: Adds an entry to the hash of a matrix.
+ * => See header file for more informations.
+ */
+	UINT32
+ldpc_codec_hash	(UINT32		hash,
+		 int		row,
+		 int		seqno)
+{
+	UINT64	x = ((UINT64)(UINT32)row << 32) | (UINT32)seqno;
+
+	// 64-bit finalizer of MurmurHash3, entries are then summed
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return hash + (UINT32)x;
+}
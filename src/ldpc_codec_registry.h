@@ -0,0 +1,81 @@
+#ifndef LDPC_CODEC_REGISTRY_H /* { */
+#define LDPC_CODEC_REGISTRY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "ldpc_types.h"
+#include "ldpc_create_pchk.h"
+
+/**
+ * Registry of specialized encoders.
+ * For a fixed (type, k, n-k, symbol size...) profile, ldpc_gencodec
+ * (see demos/ldpc_gencodec.c) turns the parity check matrix into C code:
+ * each parity symbol is computed in a single pass, as the XOR sum of a
+ * fixed list of symbols over a fixed number of bytes, without reading
+ * the matrix. The compiler can then unroll and vectorize the whole
+ * encoder, which matters for small blocks, where going through the
+ * matrix costs as much as the XOR sums themselves.
+ * The application links the generated file and registers its profile:
+ * the coding sessions created afterwards with the same parameters use it
+ * in EncodeBlock and EncodeBlockParallel, when all the source symbols
+ * are full length (symbolSize bytes). Other sessions and calls are not
+ * affected.
+ * The registry is protected by a mutex, and holds up to LDPC_CODEC_MAX
+ * profiles.
+ */
+#define LDPC_CODEC_MAX	64
+
+/**
+ * Encoder of a profile.
+ * @param symbols	(IN-OUT) the n symbols of the block, the k source
+ *			symbols first: the n-k parity symbols are built
+ *			(they need not be cleared).
+ */
+typedef void (*ldpc_codec_encode_func) (UINT8 **symbols);
+
+typedef struct {
+	// session parameters (the key)
+	SessionType	type;
+	int		nbSourceSymbols;
+	int		nbParitySymbols;
+	unsigned int	symbolSize;
+	make_method	makeMethod;	// PEG for sessions with FLAG_PEG
+	int		leftDegree;
+	int		seed;
+	bool		no4cycle;	// for sessions with FLAG_NO4CYCLE
+
+	// hash of the matrix the encoder was generated from (see
+	// ldpc_codec_hash), so that a profile generated by another version
+	// of the matrix construction is not used.
+	UINT32		matrixHash;
+	ldpc_codec_encode_func	encode;
+} ldpc_codec_profile;
+
+/**
+ * Registers a profile, which must remain valid until unregistered. If
+ * several profiles have the same parameters, the last one registered is
+ * used.
+ * @return		0 if ok, -1 if the registry is full.
+ */
+int ldpc_codec_register (const ldpc_codec_profile *profile);
+
+/**
+ * Unregisters a profile. Sessions already using it keep on using it.
+ */
+void ldpc_codec_unregister (const ldpc_codec_profile *profile);
+
+/**
+ * Returns the profile registered for these parameters, NULL if none.
+ */
+const ldpc_codec_profile* ldpc_codec_find (SessionType type, int nbSourceSymbols, int nbParitySymbols, unsigned int symbolSize, make_method makeMethod, int leftDegree, int seed, bool no4cycle);
+
+/**
+ * Adds the entry of the matrix for symbol seqno in row (parity equation)
+ * row to the hash of a matrix. The hash of a matrix is the sum over all
+ * its entries of ldpc_codec_hash(0, row, seqno), the diagonal of the
+ * parity part excepted: it does not depend on the order of the entries.
+ */
+UINT32 ldpc_codec_hash (UINT32 hash, int row, int seqno);
+
+#endif /* } LDPC_CODEC_REGISTRY_H */
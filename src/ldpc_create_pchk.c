@@ -5,17 +5,84 @@
 
 #include "ldpc_create_pchk.h"
 
-mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod, int leftDegree, int seed, bool no4cycle, SessionType type)
+/*
+ * Removes the cycles of length four going through a source column, by
+ * moving one of their entries of this column to another row chosen at
+ * random, in up to PCHK_NO4CYCLE_PASSES passes over the matrix (a move
+ * may create another cycle). Cycles within the parity columns (triangle)
+ * are part of the structure and left as is.
+ * Column j is in such a cycle if another column shares two of its rows:
+ * the columns met in the rows of j are marked as they are walked.
+ * Returns false if out of memory.
+ */
+	static bool
+RemoveCycles4 (mod2sparse *pchkMatrix, int skipCols, ldpc_prng *prng)
+{
+	mod2entry *e, *f;
+	int *rowMark;		// rows of the current column
+	int *colMark;		// columns met in the rows walked so far
+	int i, j, w, pass, moved, stamp = 0;
+	bool ok = false;
+
+	rowMark = (int*)calloc(mod2sparse_rows(pchkMatrix), sizeof(int));
+	colMark = (int*)calloc(mod2sparse_cols(pchkMatrix), sizeof(int));
+	if (rowMark == NULL || colMark == NULL)
+		goto end;
+	for (pass = 0; pass < PCHK_NO4CYCLE_PASSES; pass++) {
+		moved = 0;
+		for (j = skipCols; j < mod2sparse_cols(pchkMatrix); j++) {
+			stamp++;
+			w = 0;
+			for (e = mod2sparse_first_in_col(pchkMatrix, j); !mod2sparse_at_end(e); e = mod2sparse_next_in_col(e)) {
+				rowMark[mod2sparse_row(e)] = stamp;
+				w++;
+			}
+			if (w == mod2sparse_rows(pchkMatrix)) {
+				/* a full column cannot avoid cycles */
+				continue;
+			}
+			for (e = mod2sparse_first_in_col(pchkMatrix, j); !mod2sparse_at_end(e); e = mod2sparse_next_in_col(e)) {
+				for (f = mod2sparse_first_in_row(pchkMatrix, mod2sparse_row(e)); !mod2sparse_at_end(f); f = mod2sparse_next_in_row(f)) {
+					if (f == e)
+						continue;
+					if (colMark[mod2sparse_col(f)] == stamp)
+						goto move;	// second row shared with j
+					colMark[mod2sparse_col(f)] = stamp;
+				}
+			}
+			continue;
+move:
+			/* e goes to a row not in column j yet */
+			do {
+				i = ldpc_rand(prng, mod2sparse_rows(pchkMatrix));
+			} while (rowMark[i] == stamp);
+			mod2sparse_delete(pchkMatrix, e);
+			mod2sparse_insert(pchkMatrix, i, j);
+			moved++;
+		}
+		if (moved == 0)
+			break;
+	}
+	ok = true;
+end:
+	free(rowMark);
+	free(colMark);
+	return ok;
+}
+
+
+mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod, int leftDegree, ldpc_prng *prng, bool no4cycle, SessionType type)
 {
 	mod2entry *e;
 	int added, uneven;
 	int i, j, k, t, l;
 	int *u;
 	mod2sparse *pchkMatrix = NULL;
+	mod2csr *csrMatrix;
 	int skipCols = 0;		// avoid warning
 	int nbDataCols = 0;		// avoid warning
 
-	if (type != TypeLDGM && type != TypeSTAIRS && type != TypeTRIANGLE) {
+	if (type != TypeLDGM && type != TypeSTAIRS && type != TypeTRIANGLE && type != TypeQCSTAIRS) {
 		return NULL;
 	}
 	skipCols = nbRows;
@@ -26,11 +93,26 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 	{
 		return NULL;
 	}
-	if (no4cycle) { 
-		exit(-1);
+	if (makeMethod == PEG || type == TypeQCSTAIRS) {
+		// built in compressed form, see CreatePegMatrix and
+		// CreateQCPchkMatrix
+		if (type == TypeQCSTAIRS && no4cycle) {
+			fprintf(stderr, "CreatePchkMatrix: ERROR, no4cycle is not supported with quasi-cyclic matrices\n");
+			return NULL;
+		}
+		csrMatrix = CreatePchkMatrixCompressed(nbRows, nbCols, makeMethod, leftDegree, prng, false, type);
+		if (csrMatrix == NULL)
+			return NULL;
+		pchkMatrix = mod2sparse_from_csr(csrMatrix);
+		mod2csr_free(csrMatrix);
+		if (pchkMatrix != NULL && no4cycle && !RemoveCycles4(pchkMatrix, skipCols, prng)) {
+			mod2sparse_free(pchkMatrix);
+			free(pchkMatrix);
+			return NULL;
+		}
+		return pchkMatrix;
 	}
 
-	ldpc_srand(seed);
 	pchkMatrix = mod2sparse_allocate(nbRows, nbCols);
 
 	/* Create the initial version of the parity check matrix. */
@@ -43,7 +125,7 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 				{
 					do
 					{
-						i = ldpc_rand(nbRows);
+						i = ldpc_rand(prng, nbRows);
 					}
 					while (mod2sparse_find(pchkMatrix,i,j));
 					mod2sparse_insert(pchkMatrix,i,j);
@@ -71,7 +153,7 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 					{
 						/* choose one index within the list of possible choices */
 						do {
-							i = t + ldpc_rand(leftDegree*nbDataCols-t);
+							i = t + ldpc_rand(prng, leftDegree*nbDataCols-t);
 						} while (mod2sparse_find(pchkMatrix,u[i],j));
 						mod2sparse_insert(pchkMatrix,u[i],j);
 						/* replace with u[t] which has never been chosen */
@@ -83,7 +165,7 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 						/* no choice left, choose one randomly */
 						uneven += 1;
 						do {
-							i = ldpc_rand(nbRows);
+							i = ldpc_rand(prng, nbRows);
 						} while (mod2sparse_find(pchkMatrix,i,j));
 						mod2sparse_insert(pchkMatrix,i,j);
 					}
@@ -103,7 +185,7 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 		e = mod2sparse_first_in_row(pchkMatrix,i);
 		if(mod2sparse_at_end(e))
 		{
-			j = (ldpc_rand(nbDataCols))+skipCols;
+			j = (ldpc_rand(prng, nbDataCols))+skipCols;
 			e = mod2sparse_insert(pchkMatrix,i,j);
 			added ++;
 		}
@@ -112,7 +194,7 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 		{ 
 			do 
 			{ 
-				j = (ldpc_rand(nbDataCols))+skipCols; 
+				j = (ldpc_rand(prng, nbDataCols))+skipCols; 
 			} while (j==mod2sparse_col(e));
 			mod2sparse_insert(pchkMatrix,i,j);
 			added ++;
@@ -127,8 +209,8 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 		{
 			do
 			{
-				i = ldpc_rand(nbRows);
-				j = (ldpc_rand(nbDataCols))+skipCols;
+				i = ldpc_rand(prng, nbRows);
+				j = (ldpc_rand(prng, nbDataCols))+skipCols;
 			} while (mod2sparse_find(pchkMatrix,i,j));
 			mod2sparse_insert(pchkMatrix,i,j);
 		}
@@ -162,13 +244,594 @@ mod2sparse* CreatePchkMatrix (  int nbRows, int nbCols, make_method makeMethod,
 				/* triangle */	
 				j = i-1;
 				for (l = 0; l < j; l++) { /* limit the # of "1s" added */
-					j = ldpc_rand(j);
+					j = ldpc_rand(prng, j);
 					mod2sparse_insert(pchkMatrix, i, j);
 				}
 			}
 			break;
+
+		case TypeQCSTAIRS:	/* see CreateQCPchkMatrix */
+			break;
+	}
+
+	if (no4cycle && !RemoveCycles4(pchkMatrix, skipCols, prng)) {
+		mod2sparse_free(pchkMatrix);
+		free(pchkMatrix);
+		return NULL;
 	}
 
 	return pchkMatrix;
 }
 
+
+
+/*
+ * Entries of a matrix being built by CreatePchkMatrixCompressed, in the
+ * order they are added.
+ */
+typedef struct {
+	int	*rows;
+	int	*cols;
+	int	nb;
+	int	max;
+	bool	failed;		// out of memory, some entries are missing
+} pchk_entries;
+
+	static void
+entries_add (pchk_entries *list, int row, int col)
+{
+	int	*rows, *cols;
+
+	if (list->nb == list->max) {
+		rows = (int*)realloc(list->rows, 2 * list->max * sizeof(int));
+		if (rows != NULL)
+			list->rows = rows;
+		cols = (int*)realloc(list->cols, 2 * list->max * sizeof(int));
+		if (cols != NULL)
+			list->cols = cols;
+		if (rows == NULL || cols == NULL) {
+			list->failed = true;
+			return;
+		}
+		list->max *= 2;
+	}
+	list->rows[list->nb] = row;
+	list->cols[list->nb] = col;
+	list->nb++;
+}
+
+/*
+ * True if (row, col) is one of the entries added since entry 'from'.
+ */
+	static bool
+entries_find (pchk_entries *list, int from, int row, int col)
+{
+	int	p;
+
+	for (p = from; p < list->nb; p++) {
+		if (list->rows[p] == row && list->cols[p] == col)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Whether giving shift s to the circulant at position p of block column
+ * c would make cycles of length four with the circulants of the previous
+ * block columns: with blocks (r1, c), (r1, d), (r2, d) and (r2, c), this
+ * happens when the shifts verify s(r1,c) - s(r1,d) + s(r2,d) - s(r2,c) = 0
+ * modulo z. The staircase makes one too when the circulants of two
+ * successive block rows of c have the same shift. The circulants of block
+ * column c before p are set.
+ */
+	static bool
+qc_makes_cycle4 (mod2qc *qc, int c, int p, int s)
+{
+	int	r1, r2, q, d, x, y, s1, s2;
+
+	r2 = qc->col_blk[p];
+	for (q = mod2qc_col_begin(qc, c); q < p; q++) {
+		r1 = qc->col_blk[q];
+		if (r1 == r2 - 1 && qc->col_shift[q] == s)
+			return true;
+		// block columns d < c having a circulant in block row r1 (the
+		// block rows of all the block columns are set and indexed)
+		for (x = mod2qc_row_begin(qc, r1); x < mod2qc_row_end(qc, r1) && qc->row_blk[x] < c; x++) {
+			d = qc->row_blk[x];
+			s1 = s2 = -1;
+			for (y = mod2qc_col_begin(qc, d); y < mod2qc_col_end(qc, d); y++) {
+				if (qc->col_blk[y] == r1)
+					s1 = qc->col_shift[y];
+				else if (qc->col_blk[y] == r2)
+					s2 = qc->col_shift[y];
+			}
+			if (s2 >= 0 && ((qc->col_shift[q] - s1 + s2 - s) % qc->z + qc->z) % qc->z == 0)
+				return true;
+		}
+	}
+	return false;
+}
+
+
+/******************************************************************************
+ * CreateQCPchkMatrix: Creates a quasi-cyclic LDPC-Staircase matrix.
+ * => See header file for more informations.
+ */
+mod2qc* CreateQCPchkMatrix (int nbRows, int nbCols, int leftDegree, ldpc_prng *prng)
+{
+	mod2qc	*qc;
+	int	*u;		// pool of block rows not taken yet
+	int	z, c, p, q, r, t, s, left, try;
+
+	z = mod2qc_block_size(nbRows, nbCols);
+	if (nbCols <= nbRows || leftDegree < 1 || leftDegree > nbRows / z) {
+		fprintf(stderr, "CreateQCPchkMatrix: ERROR, invalid left degree %d\n", leftDegree);
+		return NULL;
+	}
+	if ((qc = mod2qc_allocate(nbRows, nbCols, z, (nbCols - nbRows) / z * leftDegree)) == NULL)
+		return NULL;
+	if ((u = (int*)malloc(qc->nnz * sizeof(int))) == NULL) {
+		mod2qc_free(qc);
+		return NULL;
+	}
+
+	// 1- block rows of each block column, taken from a pool holding
+	// each block row the same number of times (as Evenboth does), all
+	// different within a block column and in increasing order
+	for (t = 0; t < qc->nnz; t++) {
+		u[t] = t % qc->mb;
+		qc->col_shift[t] = 0;
+	}
+	left = qc->nnz;
+	for (c = 0; c < qc->kb; c++) {
+		qc->col_ptr[c] = c * leftDegree;
+		for (p = c * leftDegree; p < (c + 1) * leftDegree; p++) {
+			for (try = 0; try < PCHK_QC_TRIES; try++) {
+				t = ldpc_rand(prng, left);
+				for (q = c * leftDegree; q < p && qc->col_blk[q] != u[t]; q++)
+					;
+				if (q == p)
+					break;
+			}
+			if (try < PCHK_QC_TRIES) {
+				r = u[t];
+				u[t] = u[--left];
+			} else {
+				// the pool is exhausted or badly balanced: any
+				// block row not used yet
+				do {
+					r = ldpc_rand(prng, qc->mb);
+					for (q = c * leftDegree; q < p && qc->col_blk[q] != r; q++)
+						;
+				} while (q < p);
+			}
+			for (q = p; q > c * leftDegree && qc->col_blk[q - 1] > r; q--) {
+				qc->col_blk[q] = qc->col_blk[q - 1];
+			}
+			qc->col_blk[q] = r;
+		}
+	}
+	qc->col_ptr[qc->kb] = qc->nnz;
+	mod2qc_index_rows(qc);
+
+	// 2- shifts, chosen at random among those not making 4-cycles
+	// with the previous block columns when possible
+	for (c = 0; c < qc->kb; c++) {
+		for (p = mod2qc_col_begin(qc, c); p < mod2qc_col_end(qc, c); p++) {
+			try = 0;
+			do {
+				s = ldpc_rand(prng, z);
+			} while (z > 1 && ++try < PCHK_QC_TRIES && qc_makes_cycle4(qc, c, p, s));
+			qc->col_shift[p] = s;
+		}
+	}
+	mod2qc_index_rows(qc);
+
+	free(u);
+	return qc;
+}
+
+/*
+ * Adds the entries of the parity columns (identity, staircase or
+ * triangle), which are all different.
+ */
+	static void
+entries_add_parity (pchk_entries *list, int nbRows, ldpc_prng *prng, SessionType type)
+{
+	int	i, j, l;
+
+	switch (type) {
+		case TypeLDGM:
+			for (i = 0; i < nbRows; i++) {
+				/* identity */
+				entries_add(list, i, i);
+			}
+			break;
+
+		case TypeSTAIRS:
+			entries_add(list, 0, 0);	/* 1st row */
+			for (i = 1; i < nbRows; i++) {		/* for all other rows */
+				/* identity */
+				entries_add(list, i, i);
+				/* staircase */
+				entries_add(list, i, i-1);
+			}
+			break;
+
+		case TypeTRIANGLE:
+			entries_add(list, 0, 0);	/* 1st row */
+			for (i = 1; i < nbRows; i++) {		/* for all other rows */
+				/* identity */
+				entries_add(list, i, i);
+				/* staircase */
+				entries_add(list, i, i-1);
+				/* triangle: the columns chosen for a row are
+				   decreasing, hence all different */
+				j = i-1;
+				for (l = 0; l < j; l++) { /* limit the # of "1s" added */
+					j = ldpc_rand(prng, j);
+					entries_add(list, i, j);
+				}
+			}
+			break;
+
+		case TypeQCSTAIRS:	/* see CreateQCPchkMatrix */
+			break;
+	}
+}
+
+/*
+ * Nodes adjacent to a node of the Tanner graph of a matrix being built by
+ * CreatePegMatrix.
+ */
+typedef struct {
+	int	*nodes;
+	int	nb;
+	int	max;
+} peg_list;
+
+	static bool
+peg_list_add (peg_list *list, int node)
+{
+	int	*nodes;
+
+	if (list->nb == list->max) {
+		nodes = (int*)realloc(list->nodes, (list->max ? 2 * list->max : 4) * sizeof(int));
+		if (nodes == NULL)
+			return false;
+		list->nodes = nodes;
+		list->max = list->max ? 2 * list->max : 4;
+	}
+	list->nodes[list->nb++] = node;
+	return true;
+}
+
+/*
+ * Returns one of the nb candidate checks with the lowest degree, chosen
+ * at random. The candidates array is overwritten.
+ */
+	static int
+peg_pick (int *candidates, int nb, peg_list *checks, ldpc_prng *prng)
+{
+	int	i, c, minDegree = -1, nbMin = 0;
+
+	for (i = 0; i < nb; i++) {
+		c = candidates[i];
+		if (minDegree < 0 || checks[c].nb < minDegree) {
+			minDegree = checks[c].nb;
+			nbMin = 0;
+		}
+		if (checks[c].nb == minDegree)
+			candidates[nbMin++] = c;
+	}
+	return candidates[ldpc_rand(prng, nbMin)];
+}
+
+/*
+ * Builds a matrix by progressive edge growth: the parity columns are
+ * set first, then the leftDegree entries of each source column are added
+ * one by one, each in a check (row) as far as possible from this column
+ * in the graph built so far, which maximizes the local girth. The graph
+ * is explored breadth first from the column: the new entry goes in one of
+ * the checks never reached, or if all of them are, in one of the last
+ * ones reached. Ties are broken by the lowest check degree, then at
+ * random.
+ * The exploration stops after PCHK_PEG_DEPTH levels: this is enough to
+ * avoid the cycles shorter than 2*PCHK_PEG_DEPTH+4 whenever possible,
+ * and bounds its cost for large blocks. Picking a check among those not
+ * reached still costs O(n-k) per entry, i.e. O(k^2) for a code of rate
+ * k/n: PEG is meant for the small and medium blocks, for which short
+ * cycles hurt decoding most.
+ */
+	static mod2csr*
+CreatePegMatrix (int nbRows, int nbCols, int leftDegree, ldpc_prng *prng, SessionType type)
+{
+	pchk_entries list;
+	mod2csr *pchkMatrix = NULL;
+	peg_list *checks;	// Array: columns of each row
+	peg_list *vars;		// Array: rows of each column
+	int *checkMark, *varMark, stamp = 0;
+	int *frontier, *next, *tmp;
+	int nbFrontier, nbNext, nbReached, depth;
+	int i, j, k, c, f, v, p;
+	bool ok = true;
+
+	list.nb = 0;
+	list.max = leftDegree*(nbCols-nbRows) + 4*nbRows + 2;
+	list.failed = false;
+	list.rows = (int*)malloc(list.max * sizeof(int));
+	list.cols = (int*)malloc(list.max * sizeof(int));
+	checks = (peg_list*)calloc(nbRows, sizeof(peg_list));
+	vars = (peg_list*)calloc(nbCols, sizeof(peg_list));
+	checkMark = (int*)calloc(nbRows, sizeof(int));
+	varMark = (int*)calloc(nbCols, sizeof(int));
+	frontier = (int*)malloc(nbRows * sizeof(int));
+	next = (int*)malloc(nbRows * sizeof(int));
+	if (list.rows == NULL || list.cols == NULL || checks == NULL || vars == NULL ||
+			checkMark == NULL || varMark == NULL || frontier == NULL || next == NULL) {
+		goto end;
+	}
+
+	entries_add_parity(&list, nbRows, prng, type);
+	for (p = 0; p < list.nb && ok; p++) {
+		ok = peg_list_add(&checks[list.rows[p]], list.cols[p]) &&
+			peg_list_add(&vars[list.cols[p]], list.rows[p]);
+	}
+
+	for (j = nbRows; j < nbCols && ok; j++) {	/* for each source column */
+		for (k = 0; k < leftDegree && ok; k++) {
+			/* checks at distance 0: those of column j */
+			stamp++;
+			varMark[j] = stamp;
+			nbFrontier = 0;
+			for (i = 0; i < vars[j].nb; i++) {
+				checkMark[vars[j].nodes[i]] = stamp;
+				frontier[nbFrontier++] = vars[j].nodes[i];
+			}
+			nbReached = nbFrontier;
+			for (depth = 1; ; depth++) {
+				/* checks at the next distance (once all of them are
+				   reached, the rest of the level is useless) */
+				nbNext = 0;
+				for (f = 0; f < nbFrontier && nbReached + nbNext < nbRows; f++) {
+					peg_list *chk = &checks[frontier[f]];
+
+					for (i = 0; i < chk->nb && nbReached + nbNext < nbRows; i++) {
+						v = chk->nodes[i];
+						if (varMark[v] == stamp)
+							continue;
+						varMark[v] = stamp;
+						for (p = 0; p < vars[v].nb; p++) {
+							c = vars[v].nodes[p];
+							if (checkMark[c] != stamp) {
+								checkMark[c] = stamp;
+								next[nbNext++] = c;
+							}
+						}
+					}
+				}
+				nbReached += nbNext;
+				if (nbNext == 0 || (depth == PCHK_PEG_DEPTH && nbReached < nbRows)) {
+					/* nothing more reachable, or far enough: pick a
+					   check not reached */
+					nbNext = 0;
+					for (c = 0; c < nbRows; c++) {
+						if (checkMark[c] != stamp)
+							next[nbNext++] = c;
+					}
+					break;
+				}
+				if (nbReached == nbRows) {
+					/* all reached: pick one of the farthest */
+					break;
+				}
+				tmp = frontier; frontier = next; next = tmp;
+				nbFrontier = nbNext;
+			}
+			if (nbNext == 0) {
+				/* column j already in all the rows */
+				break;
+			}
+			c = peg_pick(next, nbNext, checks, prng);
+			entries_add(&list, c, j);
+			ok = peg_list_add(&checks[c], j) && peg_list_add(&vars[j], c);
+		}
+	}
+
+	if (ok && !list.failed)
+		pchkMatrix = mod2csr_from_entries(nbRows, nbCols, list.nb, list.rows, list.cols);
+end:
+	for (i = 0; checks != NULL && i < nbRows; i++)
+		free(checks[i].nodes);
+	for (j = 0; vars != NULL && j < nbCols; j++)
+		free(vars[j].nodes);
+	free(checks);
+	free(vars);
+	free(checkMark);
+	free(varMark);
+	free(frontier);
+	free(next);
+	free(list.rows);
+	free(list.cols);
+	return pchkMatrix;
+}
+
+mod2csr* CreatePchkMatrixCompressed (int nbRows, int nbCols, make_method makeMethod, int leftDegree, ldpc_prng *prng, bool no4cycle, SessionType type)
+{
+	pchk_entries list;
+	mod2csr *pchkMatrix = NULL;
+	mod2sparse *sparse;
+	int *rowWeight = NULL;	// number of entries per row
+	int *rowCol = NULL;	// last column added per row
+	int *u = NULL;
+	int added;
+	int i, j, k, t, from;
+	int skipCols, nbDataCols;
+	mod2qc *qc;
+
+	if (type != TypeLDGM && type != TypeSTAIRS && type != TypeTRIANGLE && type != TypeQCSTAIRS) {
+		return NULL;
+	}
+	skipCols = nbRows;
+	nbDataCols = nbCols-skipCols;
+
+	// Check for some problems.
+	if (leftDegree>nbRows || nbDataCols<1)
+	{
+		return NULL;
+	}
+	if (type == TypeQCSTAIRS) {
+		if (makeMethod == PEG || no4cycle) {
+			fprintf(stderr, "CreatePchkMatrixCompressed: ERROR, PEG and no4cycle are not supported with quasi-cyclic matrices\n");
+			return NULL;
+		}
+		if ((qc = CreateQCPchkMatrix(nbRows, nbCols, leftDegree, prng)) == NULL)
+			return NULL;
+		pchkMatrix = mod2csr_from_qc(qc);
+		mod2qc_free(qc);
+		return pchkMatrix;
+	}
+	if (no4cycle) { 
+		// cycles are removed by moving entries, on the sparse form
+		if ((sparse = CreatePchkMatrix(nbRows, nbCols, makeMethod, leftDegree, prng, true, type)) == NULL)
+			return NULL;
+		pchkMatrix = mod2csr_from_sparse(sparse);
+		mod2sparse_free(sparse);
+		free(sparse);	/* mod2sparse_free does not free it! */
+		return pchkMatrix;
+	}
+	if (makeMethod == PEG) {
+		return CreatePegMatrix(nbRows, nbCols, leftDegree, prng, type);
+	}
+
+	// enough for all the entries but the triangle ones
+	list.nb = 0;
+	list.max = leftDegree*nbDataCols + 4*nbRows + 2;
+	list.failed = false;
+	list.rows = (int*)malloc(list.max * sizeof(int));
+	list.cols = (int*)malloc(list.max * sizeof(int));
+	rowWeight = (int*)calloc(nbRows, sizeof(int));
+	rowCol = (int*)calloc(nbRows, sizeof(int));
+	if (makeMethod == Evenboth)
+		u = (int*)calloc(leftDegree*nbDataCols, sizeof(*u));
+	if (list.rows == NULL || list.cols == NULL || rowWeight == NULL || rowCol == NULL ||
+			(makeMethod == Evenboth && u == NULL)) {
+		goto end;
+	}
+
+	/* Create the initial version of the parity check matrix. Until the
+	   extra bits, a column only holds the entries added since it was
+	   started: they are the set checked for duplicates. */
+	switch (makeMethod)
+	{ 
+		case Evencol:
+			for(j=skipCols; j<nbCols; j++)
+			{
+				from = list.nb;
+				for(k=0; k<leftDegree; k++)
+				{
+					do
+					{
+						i = ldpc_rand(prng, nbRows);
+					}
+					while (entries_find(&list, from, i, j));
+					entries_add(&list, i, j);
+				}
+			}
+			break;
+
+		case Evenboth:
+			for(k = leftDegree*nbDataCols-1; k>=0; k--)
+			{
+				u[k] = k%nbRows;
+			}
+			t = 0;	/* left limit within the list of possible choices, u[] */
+			for(j = skipCols; j<nbCols; j++)	/* for each source symbol column */
+			{
+				from = list.nb;
+				for(k = 0; k<leftDegree; k++)	/* add left_degree "1s" */
+				{ 
+					/* check that valid available choices remain */
+					for(i = t; i<leftDegree*nbDataCols && entries_find(&list, from, u[i], j); i++) ;
+
+					if(i < leftDegree*nbDataCols)
+					{
+						/* choose one index within the list of possible choices */
+						do {
+							i = t + ldpc_rand(prng, leftDegree*nbDataCols-t);
+						} while (entries_find(&list, from, u[i], j));
+						entries_add(&list, u[i], j);
+						/* replace with u[t] which has never been chosen */
+						u[i] = u[t];
+						t++;
+					}
+					else
+					{
+						/* no choice left, choose one randomly */
+						do {
+							i = ldpc_rand(prng, nbRows);
+						} while (entries_find(&list, from, i, j));
+						entries_add(&list, i, j);
+					}
+				}
+			}
+			break;
+
+		default: abort();
+	}
+	for (k = 0; k < list.nb; k++) {
+		rowWeight[list.rows[k]]++;
+		rowCol[list.rows[k]] = list.cols[k];
+	}
+
+	/* Add extra bits to avoid rows with less than two checks. */
+	added = 0;
+	for(i = 0; i<nbRows; i++)
+	{
+		if(rowWeight[i] == 0)
+		{
+			j = (ldpc_rand(prng, nbDataCols))+skipCols;
+			entries_add(&list, i, j);
+			rowWeight[i]++;
+			rowCol[i] = j;
+			added ++;
+		}
+		if(rowWeight[i] == 1 && nbDataCols>1)
+		{ 
+			do 
+			{ 
+				j = (ldpc_rand(prng, nbDataCols))+skipCols; 
+			} while (j==rowCol[i]);
+			entries_add(&list, i, j);
+			added ++;
+		}
+	}
+
+	/* Add extra bits to try to avoid problems with even column counts. */
+	if(leftDegree%2==0 && leftDegree<nbRows && nbDataCols>1 && added<2)
+	{
+		int a;
+		for(a = 0; added+a<2; a++)
+		{
+			do
+			{
+				i = ldpc_rand(prng, nbRows);
+				j = (ldpc_rand(prng, nbDataCols))+skipCols;
+			} while (entries_find(&list, 0, i, j));
+			entries_add(&list, i, j);
+		}
+	}
+
+	/* The parity columns were empty so far: no duplicate here. */
+	entries_add_parity(&list, nbRows, prng, type);
+
+	if (!list.failed)
+		pchkMatrix = mod2csr_from_entries(nbRows, nbCols, list.nb, list.rows, list.cols);
+end:
+	free(list.rows);
+	free(list.cols);
+	free(rowWeight);
+	free(rowCol);
+	free(u);
+	return pchkMatrix;
+}
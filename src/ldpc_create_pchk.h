@@ -3,33 +3,56 @@
 
 #include <stdbool.h>
 #include "ldpc_matrix_sparse.h"
+#include "ldpc_matrix_compressed.h"
+#include "ldpc_matrix_qc.h"
 
 typedef enum make_method_enum
 {
 	Evencol, 	/* Uniform number of bits per column, with number specified */
-	Evenboth 	/* Uniform (as possible) over both columns and rows */
+	Evenboth, 	/* Uniform (as possible) over both columns and rows */
+	PEG		/* Progressive edge growth: maximizes the local girth */
 } make_method; 
 
+/* Maximum number of passes over the matrix to remove its 4-cycles. */
+#define PCHK_NO4CYCLE_PASSES	10
+
+/* Number of random tries to place a circulant of a quasi-cyclic matrix. */
+#define PCHK_QC_TRIES		16
+
+/* Depth of the graph explored by PEG for each new entry: no cycle
+   shorter than 2*PCHK_PEG_DEPTH+4 is created while it can be avoided. */
+#define PCHK_PEG_DEPTH		2
+
 
 typedef enum SessionType_enum
 {
 	TypeLDGM,
 	TypeSTAIRS,
-	TypeTRIANGLE
+	TypeTRIANGLE,
+	TypeQCSTAIRS	/* quasi-cyclic LDPC-Staircase, see CreateQCPchkMatrix */
 } SessionType;
 
-static unsigned long seed;
+/**
+ * State of the PRNG used to build a parity check matrix.
+ * There is no global state: each matrix creation uses its own generator,
+ * so that matrices can be created concurrently by several threads.
+ */
+typedef struct {
+	unsigned long	seed;	// current value, between 1 and 0x7FFFFFFE
+} ldpc_prng;
 
 /**
  * Initialize the PRNG with a seed between 1 and 0x7FFFFFFE
  * (2^^31-2) inclusive.
+ * @return	true if the seed is valid, false otherwise.
  */
-static inline void ldpc_srand (unsigned long s)
+static inline bool ldpc_srand (ldpc_prng *prng, unsigned long s)
 {
-	if ((s >= 1) && (s <= 0x7FFFFFFE))
-		seed = s;
-	else 
-		exit(-1);
+	if ((s >= 1) && (s <= 0x7FFFFFFE)) {
+		prng->seed = s;
+		return true;
+	}
+	return false;
 }
 
 /**
@@ -38,24 +61,81 @@ static inline void ldpc_srand (unsigned long s)
  *	0x7FFFFFFF	modulo constant (2^^31-1)
  * The inner PRNG produces a value between 1 and 0x7FFFFFFE
  * (2^^31-2) inclusive.
- * This value is then scaled between 0 and maxv-1 inclusive.
+ * This value is then scaled between 0 and maxv-1 inclusive, as
+ * seed*maxv/0x7FFFFFFF computed with doubles.
  */
 static inline unsigned long
-ldpc_rand (unsigned long	maxv)
+ldpc_rand (ldpc_prng	*prng,
+	   unsigned long	maxv)
 {
 	unsigned long	hi, lo;
-	lo = 16807 * (seed & 0xFFFF);
-	hi = 16807 * (seed >> 16);
+	UINT64		p, q, r;
+	lo = 16807 * (prng->seed & 0xFFFF);
+	hi = 16807 * (prng->seed >> 16);
 	lo += (hi & 0x7FFF) << 16;
 	lo += hi >> 15;
 	if (lo > 0x7FFFFFFF)
 		lo -= 0x7FFFFFFF;
-	seed = (long) lo;
+	prng->seed = (long) lo;
+	// The exact integer quotient is the same as the double one, unless
+	// it is so close to an integer that rounding may cross it.
+	if (maxv <= 0x7FFFFFFF) {
+		p = (UINT64)prng->seed * maxv;
+		q = p / 0x7FFFFFFF;
+		r = p % 0x7FFFFFFF;
+		if (r >= 4096 && 0x7FFFFFFF - r >= 4096)
+			return (unsigned long)q;
+	}
 	return ((unsigned long)
-			((double)seed * (double)maxv / (double)0x7FFFFFFF));
+			((double)prng->seed * (double)maxv / (double)0x7FFFFFFF));
 }
 
-mod2sparse* CreatePchkMatrix (int nbRows, int nbCols, make_method makeMethod, int leftDegree, int seed, bool no4cycle, SessionType type);
+/**
+ * Creates a parity check matrix.
+ * With no4cycle, the cycles of length four going through the source
+ * columns are removed (as far as possible) once the matrix is built.
+ * This function is reentrant: the only state it uses is the generator,
+ * which must have been initialized with ldpc_srand().
+ * @param prng	(IN-OUT) generator used for all the random choices.
+ * @return	the matrix (to be freed with mod2sparse_free then free), or
+ *		NULL in case of error.
+ */
+mod2sparse* CreatePchkMatrix (int nbRows, int nbCols, make_method makeMethod, int leftDegree, ldpc_prng *prng, bool no4cycle, SessionType type);
+
+/**
+ * Creates a parity check matrix directly in compressed form.
+ * The random choices are exactly those of CreatePchkMatrix, so that the
+ * matrix is the same for the same parameters and generator state, but
+ * duplicates are only checked within the entries of the current column
+ * and the matrix is built in a single pass at the end, instead of
+ * inserting each entry in a sparse matrix: the cost is linear in the
+ * number of entries, which matters for large blocks.
+ * A PEG matrix is built in this form, a no4cycle one through
+ * CreatePchkMatrix.
+ * @param prng	(IN-OUT) generator used for all the random choices.
+ * @return	the matrix (to be freed with mod2csr_free), or NULL in case
+ *		of error.
+ */
+mod2csr* CreatePchkMatrixCompressed (int nbRows, int nbCols, make_method makeMethod, int leftDegree, ldpc_prng *prng, bool no4cycle, SessionType type);
+
+/**
+ * Creates the description of a quasi-cyclic LDPC-Staircase matrix
+ * (TypeQCSTAIRS), see mod2qc. The size z of the circulants is given by
+ * mod2qc_block_size: the description is compact when n-k and k have a
+ * large common divisor (e.g. k=1000000, n-k=500000 gives 1000x1000 bit
+ * circulants in a 500x1000 base matrix, described in about 50 KB instead
+ * of 40 MB for the compressed matrix).
+ * Each block column has leftDegree circulants, in block rows taken as
+ * evenly as possible, with random shifts chosen so as to avoid cycles of
+ * length four. For k=1000000 and n=1500000, the erasure overhead is that
+ * of TypeSTAIRS (1.067) while encoding is three times faster.
+ * The expanded matrix (CreatePchkMatrix or CreatePchkMatrixCompressed
+ * with TypeQCSTAIRS) is the same for the same generator state, the
+ * makeMethod being ignored (PEG and no4cycle are not supported).
+ * @return	the matrix (to be freed with mod2qc_free), or NULL in case of
+ *		error.
+ */
+mod2qc* CreateQCPchkMatrix (int nbRows, int nbCols, int leftDegree, ldpc_prng *prng);
 
 #endif
 
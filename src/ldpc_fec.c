@@ -1,6 +1,76 @@
+#include <pthread.h>
+#include <unistd.h>
+
 #include "ldpc_fec.h"
 
 
+/*
+ * Gives back all the symbols allocated for the current block: check node
+ * values, stored parity symbols, owned source symbols and partial sums
+ * of the streaming encoder.
+ */
+	static void
+FreeBlockSymbols (LDPCFecSession *Session)
+{
+	int i;
+
+	for (i = 0; i < Session->m_nbParitySymbols; i++) {
+		if (Session->m_checkValues != NULL) {
+			FreeSymbol(Session, Session->m_checkValues[i]);
+			FreeSymbol(Session, Session->m_parity_symbol_canvas[i]);
+		}
+		if (Session->m_parityAccumulators != NULL) {
+			FreeSymbol(Session, Session->m_parityAccumulators[i]);
+		}
+	}
+	for (i = 0; Session->m_ownedSourceSymbols != NULL && i < Session->m_nbSourceSymbols; i++) {
+		FreeSymbol(Session, Session->m_ownedSourceSymbols[i]);
+	}
+}
+
+
+/*
+ * Sets the per-block state of a session (counters, flags and worklists)
+ * as before the first symbol, from the compressed matrix. The arrays
+ * must be allocated and zeroed.
+ */
+	static void
+InitBlockState (LDPCFecSession *Session)
+{
+	int row, seq;
+
+	if (Session->m_nb_unknown_symbols_encoder != NULL) {
+		for (row = 0; row < Session->m_nbParitySymbols; row++) {
+			Session->m_nb_unknown_symbols_encoder[row] = (Session->m_qcMatrix != NULL) ?
+				mod2qc_row_weight(Session->m_qcMatrix, row) :
+				mod2csr_row_weight(Session->m_pchkCompressed, row);
+		}
+	}
+	if (Session->m_nbSymbols_in_equ != NULL) {
+		for (row = 0; row < Session->m_nbParitySymbols; row++) {
+			Session->m_nbSymbols_in_equ[row] =
+				mod2csr_row_weight(Session->m_pchkCompressed, row);
+			Session->m_nb_unknown_symbols[row] = Session->m_nbSymbols_in_equ[row];
+		}
+		for (seq = Session->m_nbSourceSymbols; seq < (Session->m_nbParitySymbols+Session->m_nbSourceSymbols); seq++) {
+			Session->m_nbEqu_for_parity[seq - Session->m_nbSourceSymbols] =
+				mod2csr_col_weight(Session->m_pchkCompressed, GetMatrixCol(Session, seq));
+		}
+	}
+	Session->m_parityReady_nb = 0;
+	Session->m_firstNonDecoded = 0;
+	Session->m_nbMissingSources = Session->m_nbSourceSymbols;
+	Session->m_checkOfDeg1_nb = 0;
+	Session->m_nbReceived = 0;
+	Session->m_mlRetryAt = 0;
+	Session->m_nextDelivered = 0;
+}
+
+
+static const ldpc_codec_profile* FindCodecProfile (LDPCFecSession *Session, int seed);
+static void FreeSession (LDPCFecSession *Session);
+
+
 /******************************************************************************
  * InitSession : Initializes the LDPC session.
  * => See header file for more informations.
@@ -16,8 +86,7 @@ InitSession (
 		SessionType codecType,
 		int leftDegree)
 {
-	int row, seq;
-	mod2entry	*e;
+	ldpc_prng	prng;
 
 	Session->m_initialized	= false;
 	Session->m_sessionFlags	= flags;
@@ -37,64 +106,99 @@ InitSession (
 		return LDPC_ERROR;
 	}
 	Session->m_leftDegree	= leftDegree;
-	Session->m_firstNonDecoded = 0;
 
-	Session->m_pchkMatrix = CreatePchkMatrix(Session->m_nbParitySymbols, Session->m_nbSourceSymbols + Session->m_nbParitySymbols, Evenboth, Session->m_leftDegree, seed, false, Session->m_sessionType);
-	if (Session->m_pchkMatrix == NULL) 
+	if ((codecType == TypeQCSTAIRS) && (flags & (FLAG_NO4CYCLE | FLAG_PEG))) {
+		fprintf(stderr, "LDPCFecSession::InitSession: ERROR: FLAG_NO4CYCLE and FLAG_PEG do not apply to quasi-cyclic codes!\n");
 		return LDPC_ERROR;
+	}
 
-	if (Session->m_sessionFlags & FLAG_CODER) {
-		Session->m_nb_unknown_symbols_encoder = (int*)calloc(Session->m_nbParitySymbols, sizeof(int));
-		if (Session->m_nb_unknown_symbols_encoder == NULL) 
-			return LDPC_ERROR;
+	// Nothing is set up yet: if a step fails, what the previous ones
+	// set up is released (see FreeSession).
+	Session->m_pchkMatrix = NULL;
+	Session->m_pchkCacheEntry = NULL;
+	Session->m_pchkCompressed = NULL;
+	Session->m_qcMatrix = NULL;
+	Session->m_symbolPool = NULL;
+	Session->m_symbolPoolOwned = true;
+	Session->m_nb_unknown_symbols_encoder = NULL;
+	Session->m_parityAccumulators = NULL;
+	Session->m_accumulatorLengths = NULL;
+	Session->m_parityReady = NULL;
+	Session->m_sourceAdded = NULL;
+	Session->m_checkValues = NULL;
+	Session->m_checkLengths = NULL;
+	Session->m_symbolLengths = NULL;
+	Session->m_nbSymbols_in_equ = NULL;
+	Session->m_nb_unknown_symbols = NULL;
+	Session->m_nbEqu_for_parity = NULL;
+	Session->m_parity_symbol_canvas = NULL;
+	Session->m_checkOfDeg1 = NULL;
+	Session->m_ownedSourceSymbols = NULL;
+	Session->m_knownSymbols = NULL;
 
-		for (row = 0; row < Session->m_nbParitySymbols; row++) {
-			mod2entry *e;
-			for (e = mod2sparse_first_in_row(Session->m_pchkMatrix, row);
-					!mod2sparse_at_end(e);
-					e = mod2sparse_next_in_row(e)) {
-				Session->m_nb_unknown_symbols_encoder[row]++;
-			}
+	// The matrix only depends on the parameters, so get it from the
+	// process-wide cache rather than building it for each session.
+	// A quasi-cyclic coder only needs the description of the matrix.
+	if ((codecType == TypeQCSTAIRS) && (flags & FLAG_CODER) &&
+			(!ldpc_srand(&prng, seed) ||
+			 (Session->m_qcMatrix = CreateQCPchkMatrix(Session->m_nbParitySymbols,
+					Session->m_nbSourceSymbols + Session->m_nbParitySymbols,
+					Session->m_leftDegree, &prng)) == NULL)) {
+		goto error;
+	}
+	if (codecType != TypeQCSTAIRS || (flags & FLAG_DECODER)) {
+		Session->m_pchkCacheEntry = pchk_cache_acquire(Session->m_nbParitySymbols, Session->m_nbSourceSymbols + Session->m_nbParitySymbols,
+				(flags & FLAG_PEG) ? PEG : Evenboth, Session->m_leftDegree, seed,
+				(flags & FLAG_NO4CYCLE) != 0, Session->m_sessionType);
+		if (Session->m_pchkCacheEntry == NULL) 
+			goto error;
+		Session->m_pchkCompressed = Session->m_pchkCacheEntry->matrix;
+	}
+
+	// symbol buffers of the session (slabs are only allocated when
+	// needed)
+	if ((Session->m_symbolPool = symbol_pool_create(Session->m_symbolSize, 0, false)) == NULL)
+		goto error;
+	memset(&Session->m_memoryCallbacks, 0, sizeof(Session->m_memoryCallbacks));
+	Session->m_context_4_callback = NULL;
+
+	Session->m_parityCallback = NULL;
+	Session->m_parityCallbackContext = NULL;
+	Session->m_codecProfile = NULL;
+	if (Session->m_sessionFlags & FLAG_CODER) {
+		Session->m_codecProfile = FindCodecProfile(Session, seed);
+		if (((Session->m_nb_unknown_symbols_encoder = (int*)calloc(Session->m_nbParitySymbols, sizeof(int))) == NULL) ||
+				((Session->m_parityAccumulators = (void**)calloc(Session->m_nbParitySymbols, sizeof(void*))) == NULL) ||
+				((Session->m_accumulatorLengths = (unsigned int*)calloc(Session->m_nbParitySymbols, sizeof(unsigned int))) == NULL) ||
+				((Session->m_parityReady = (int*)calloc(Session->m_nbParitySymbols, sizeof(int))) == NULL) ||
+				((Session->m_sourceAdded = (bool*)calloc(Session->m_nbSourceSymbols, sizeof(bool))) == NULL)) {
+			goto error;
 		}
-	} else {
-		Session->m_nb_unknown_symbols_encoder = NULL;
 	}
 
 	if (Session->m_sessionFlags & FLAG_DECODER) {
-		if (((Session->m_checkValues	= (void**)calloc(Session->m_nbParitySymbols, sizeof(void*))) == NULL) ||
+		// the decoder deletes entries as it goes, it needs its own
+		// working copy of the shared matrix.
+		if (((Session->m_pchkMatrix = mod2sparse_from_csr(Session->m_pchkCompressed)) == NULL) ||
+				((Session->m_checkValues	= (void**)calloc(Session->m_nbParitySymbols, sizeof(void*))) == NULL) ||
+				((Session->m_checkLengths = (unsigned int*)calloc(Session->m_nbParitySymbols, sizeof(unsigned int))) == NULL) ||
+				((Session->m_symbolLengths = (unsigned int*)calloc(Session->m_nbSourceSymbols + Session->m_nbParitySymbols, sizeof(unsigned int))) == NULL) ||
 				((Session->m_nbSymbols_in_equ = (int*)calloc(Session->m_nbParitySymbols, sizeof(int))) == NULL) ||
 				((Session->m_nb_unknown_symbols = (int*)calloc(Session->m_nbParitySymbols, sizeof(int))) == NULL) ||
 				((Session->m_nbEqu_for_parity = (int*)calloc(Session->m_nbParitySymbols, sizeof(int))) == NULL) ||
-				((Session->m_parity_symbol_canvas = (void**)calloc(Session->m_nbParitySymbols, sizeof(void*))) == NULL)) {
-			return LDPC_ERROR;
+				((Session->m_parity_symbol_canvas = (void**)calloc(Session->m_nbParitySymbols, sizeof(void*))) == NULL) ||
+				((Session->m_checkOfDeg1 = (int*)calloc(Session->m_nbParitySymbols, sizeof(int))) == NULL) ||
+				((Session->m_ownedSourceSymbols = (void**)calloc(Session->m_nbSourceSymbols, sizeof(void*))) == NULL) ||
+				((Session->m_knownSymbols = (UINT64*)calloc((Session->m_nbSourceSymbols + Session->m_nbParitySymbols + 63) / 64, sizeof(UINT64))) == NULL)) {
+			goto error;
 		}
-		// and update the various tables now
-		for (row = 0; row < Session->m_nbParitySymbols; row++) {
-			for (e = mod2sparse_first_in_row(Session->m_pchkMatrix, row);
-					!mod2sparse_at_end(e);
-					e = mod2sparse_next_in_row(e))
-			{
-				Session->m_nbSymbols_in_equ[row]++;
-				Session->m_nb_unknown_symbols[row]++;
-			}
-		}
-		for (seq = Session->m_nbSourceSymbols; seq < (Session->m_nbParitySymbols+Session->m_nbSourceSymbols); seq++) {
-			for (e = mod2sparse_first_in_col(Session->m_pchkMatrix,
-						GetMatrixCol(Session, seq));
-					!mod2sparse_at_end(e);
-					e = mod2sparse_next_in_col(e))
-			{
-				Session->m_nbEqu_for_parity[seq - Session->m_nbSourceSymbols]++;
-			}
-		}
-	} else {
-		// CODER session
-		Session->m_checkValues = NULL;
-		Session->m_nbSymbols_in_equ = NULL;
-		Session->m_nb_unknown_symbols = NULL;
-		Session->m_nbEqu_for_parity = NULL;
-		Session->m_parity_symbol_canvas = NULL;
 	}
+	// and update the various tables now
+	InitBlockState(Session);
+	Session->m_mlDecoding = false;
+	Session->m_symbolCallback = NULL;
+	Session->m_symbolCallbackContext = NULL;
+	Session->m_symbolCallbackInOrder = false;
 	if ((Session->m_sessionType == TypeTRIANGLE) && (((Session->m_nbParitySymbols+Session->m_nbSourceSymbols)/Session->m_nbSourceSymbols) < 2.0)) {
 		Session->m_triangleWithSmallFECRatio = true;
 	} else {
@@ -102,83 +206,838 @@ InitSession (
 	}
 	Session->m_initialized = true;
 	return LDPC_OK;
+
+error:
+	FreeSession(Session);
+	return LDPC_ERROR;
+}
+
+
+/*
+ * Releases everything a session holds. The pointers of what was not set up
+ * must be NULL (see InitSession).
+ */
+	static void
+FreeSession (LDPCFecSession *Session)
+{
+	if (Session->m_pchkMatrix != NULL) {
+		mod2sparse_free(Session->m_pchkMatrix);
+		free(Session->m_pchkMatrix);	/* mod2sparse_free does not free it! */
+	}
+	// the compressed matrix is shared, just give it back
+	pchk_cache_release(Session->m_pchkCacheEntry);
+	mod2qc_free(Session->m_qcMatrix);
+
+	// All the symbols allocated by the session come from the pool
+	// or the application: a private pool is released at once,
+	// symbols are given back one by one otherwise.
+	if (!Session->m_symbolPoolOwned) {
+		FreeBlockSymbols(Session);
+	}
+	if (Session->m_symbolPoolOwned) {
+		symbol_pool_destroy(Session->m_symbolPool);
+	}
+	Session->m_symbolPool = NULL;
+	if (Session->m_checkValues != NULL) {
+		free(Session->m_checkValues);
+	}
+	if (Session->m_parity_symbol_canvas != NULL) {
+		free(Session->m_parity_symbol_canvas);
+	}
+	if (Session->m_checkLengths != NULL) {
+		free(Session->m_checkLengths);
+	}
+	if (Session->m_symbolLengths != NULL) {
+		free(Session->m_symbolLengths);
+	}
+	if (Session->m_ownedSourceSymbols != NULL) {
+		free(Session->m_ownedSourceSymbols);
+	}
+	if (Session->m_knownSymbols != NULL) {
+		free(Session->m_knownSymbols);
+	}
+	if (Session->m_checkOfDeg1 != NULL) {
+		free(Session->m_checkOfDeg1);
+	}
+	if (Session->m_nbSymbols_in_equ != NULL) {
+		free(Session->m_nbSymbols_in_equ);
+	}
+	if (Session->m_nbEqu_for_parity != NULL) {
+		free(Session->m_nbEqu_for_parity);
+	}
+	if (Session->m_nb_unknown_symbols != NULL) {
+		free(Session->m_nb_unknown_symbols);
+	}
+	if (Session->m_nb_unknown_symbols_encoder != NULL) {
+		free(Session->m_nb_unknown_symbols_encoder);
+	}
+	if (Session->m_parityAccumulators != NULL) {
+		free(Session->m_parityAccumulators);
+	}
+	if (Session->m_accumulatorLengths != NULL) {
+		free(Session->m_accumulatorLengths);
+	}
+	if (Session->m_parityReady != NULL) {
+		free(Session->m_parityReady);
+	}
+	if (Session->m_sourceAdded != NULL) {
+		free(Session->m_sourceAdded);
+	}
 }
 
 
 	void
 EndSession(LDPCFecSession *Session)
 {
-	int i;
-
 	if (Session->m_initialized == true) {
 		Session->m_initialized = false;
-		mod2sparse_free(Session->m_pchkMatrix);
-		free(Session->m_pchkMatrix);	/* mod2sparse_free does not free it! */
+		FreeSession(Session);
+	}
+}
 
-		if (Session->m_checkValues != NULL) {
-			for (i = 0; i < Session->m_nbParitySymbols; i++) {
-				if (Session->m_checkValues[i] != NULL) {
-					{
-						free(Session->m_checkValues[i]);
-					}
-				}
-			}
-			free(Session->m_checkValues);
+/******************************************************************************
+ * ResetSession: Makes a session ready for a new block.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+ResetSession (LDPCFecSession *Session)
+{
+	int	nbSymbols = Session->m_nbSourceSymbols + Session->m_nbParitySymbols;
+
+	if (!Session->m_initialized) {
+		fprintf(stderr, "LDPCFecSession::ResetSession: ERROR: session not initialized!\n");
+		return LDPC_ERROR;
+	}
+	// the symbols go back to the pool, whose slabs are kept for the
+	// next block.
+	FreeBlockSymbols(Session);
+
+	if (Session->m_sessionFlags & FLAG_CODER) {
+		memset(Session->m_parityAccumulators, 0, Session->m_nbParitySymbols * sizeof(void*));
+		memset(Session->m_accumulatorLengths, 0, Session->m_nbParitySymbols * sizeof(unsigned int));
+		memset(Session->m_sourceAdded, 0, Session->m_nbSourceSymbols * sizeof(bool));
+	}
+	if (Session->m_sessionFlags & FLAG_DECODER) {
+		// put back the entries deleted while decoding, in place
+		if (mod2sparse_reset_from_csr(Session->m_pchkMatrix, Session->m_pchkCompressed) < 0) {
+			fprintf(stderr, "LDPCFecSession::ResetSession: ERROR: cannot reset the parity check matrix!\n");
+			return LDPC_ERROR;
 		}
-		if (Session->m_parity_symbol_canvas != NULL) {
-			for (i = 0; i < Session->m_nbParitySymbols; i++) {
-				if (Session->m_parity_symbol_canvas[i] != NULL) {
-					free(Session->m_parity_symbol_canvas[i]);
-				}
+		memset(Session->m_checkValues, 0, Session->m_nbParitySymbols * sizeof(void*));
+		memset(Session->m_checkLengths, 0, Session->m_nbParitySymbols * sizeof(unsigned int));
+		memset(Session->m_parity_symbol_canvas, 0, Session->m_nbParitySymbols * sizeof(void*));
+		memset(Session->m_symbolLengths, 0, nbSymbols * sizeof(unsigned int));
+		memset(Session->m_ownedSourceSymbols, 0, Session->m_nbSourceSymbols * sizeof(void*));
+		memset(Session->m_knownSymbols, 0, ((nbSymbols + 63) / 64) * sizeof(UINT64));
+	}
+	InitBlockState(Session);
+	return LDPC_OK;
+}
+
+/*
+ * True if symbols may have been allocated already, i.e. some were given
+ * to the decoder or to the streaming encoder.
+ */
+	static bool
+SymbolsAllocated (LDPCFecSession *Session)
+{
+	int	i;
+
+	if (Session->m_nbReceived > 0)
+		return true;
+	for (i = 0; Session->m_sourceAdded != NULL && i < Session->m_nbSourceSymbols; i++) {
+		if (Session->m_sourceAdded[i])
+			return true;
+	}
+	return false;
+}
+
+/******************************************************************************
+ * SetSymbolPool: Makes a decoding session use a shared symbol pool.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+SetSymbolPool (LDPCFecSession *Session, symbol_pool *pool)
+{
+	if (!Session->m_initialized || Session->m_symbolPool == NULL ||
+			SymbolsAllocated(Session) || pool == NULL ||
+			pool->symbolSize < Session->m_symbolSize) {
+		fprintf(stderr, "LDPCFecSession::SetSymbolPool: ERROR: invalid pool or session already in use!\n");
+		return LDPC_ERROR;
+	}
+	if (Session->m_symbolPoolOwned) {
+		symbol_pool_destroy(Session->m_symbolPool);
+	}
+	Session->m_symbolPool = pool;
+	Session->m_symbolPoolOwned = false;
+	return LDPC_OK;
+}
+
+/******************************************************************************
+ * SetMemoryCallbacks: Makes a session use external memory management.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+SetMemoryCallbacks (LDPCFecSession *Session,
+		const ldpc_memory_callbacks *callbacks,
+		void *context)
+{
+	if (!Session->m_initialized || SymbolsAllocated(Session) || callbacks == NULL ||
+			callbacks->allocSymbol == NULL || callbacks->freeSymbol == NULL) {
+		fprintf(stderr, "LDPCFecSession::SetMemoryCallbacks: ERROR: invalid callbacks or session already in use!\n");
+		return LDPC_ERROR;
+	}
+	if (Session->m_symbolPoolOwned) {
+		symbol_pool_destroy(Session->m_symbolPool);
+	}
+	Session->m_symbolPool = NULL;
+	Session->m_symbolPoolOwned = false;
+	Session->m_memoryCallbacks = *callbacks;
+	Session->m_context_4_callback = context;
+	return LDPC_OK;
+}
+
+/******************************************************************************
+ * AllocSymbol/FreeSymbol: symbols of the session's pool, or of the
+ * application.
+ * => See header file for more informations.
+ */
+	void*
+AllocSymbol (LDPCFecSession *Session)
+{
+	if (Session->m_memoryCallbacks.allocSymbol != NULL) {
+		return Session->m_memoryCallbacks.allocSymbol(Session->m_context_4_callback,
+				Session->m_symbolSize);
+	}
+	return symbol_pool_get(Session->m_symbolPool);
+}
+
+	void
+FreeSymbol (LDPCFecSession *Session, void *symbol)
+{
+	if (symbol == NULL) {
+		return;
+	}
+	if (Session->m_memoryCallbacks.freeSymbol != NULL) {
+		Session->m_memoryCallbacks.freeSymbol(Session->m_context_4_callback, symbol);
+	} else {
+		symbol_pool_put(Session->m_symbolPool, symbol);
+	}
+}
+
+/******************************************************************************
+ * AllocDecodedSymbol: symbol in which a source symbol is stored.
+ * => See header file for more informations.
+ */
+	void*
+AllocDecodedSymbol (LDPCFecSession *Session, int symbolSeqno)
+{
+	if (Session->m_memoryCallbacks.decodedSymbol != NULL) {
+		return Session->m_memoryCallbacks.decodedSymbol(Session->m_context_4_callback,
+				Session->m_symbolSize, symbolSeqno);
+	}
+	return AllocSymbol(Session);
+}
+
+/*
+ * Entries of the rows and columns of the parity check matrix, for the
+ * coder: positions [*begin; *end[ of the compressed matrix, or for a
+ * quasi-cyclic coder (m_qcMatrix), of its circulants, preceded by the
+ * staircase entry not on the diagonal if any. RowSymbol gives the symbol
+ * of each entry of row, or -1 for parity symbol row itself. ColRow gives
+ * the row of each entry of the column of symbol seqno, or -1 for the
+ * diagonal of a parity symbol.
+ */
+	static void
+RowRange (LDPCFecSession *Session, int row, int *begin, int *end)
+{
+	mod2qc	*q = Session->m_qcMatrix;
+
+	if (q != NULL) {
+		*begin = mod2qc_row_begin(q, row / q->z) - ((row >= q->z) ? 1 : 0);
+		*end = mod2qc_row_end(q, row / q->z);
+	} else {
+		*begin = mod2csr_row_begin(Session->m_pchkCompressed, row);
+		*end = mod2csr_row_end(Session->m_pchkCompressed, row);
+	}
+}
+
+	static int
+RowSymbol (LDPCFecSession *Session, int row, int pos)
+{
+	mod2qc	*q = Session->m_qcMatrix;
+	int	col;
+
+	if (q != NULL) {
+		if (pos < mod2qc_row_begin(q, row / q->z))
+			return Session->m_nbSourceSymbols + row - q->z;	// staircase
+		return mod2qc_row_col(q, pos, row % q->z);
+	}
+	col = mod2csr_col(Session->m_pchkCompressed, pos);
+	return (col == row) ? -1 : GetSymbolSeqno(Session, col);
+}
+
+	static void
+ColRange (LDPCFecSession *Session, int seqno, int *begin, int *end)
+{
+	mod2qc	*q = Session->m_qcMatrix;
+	int	col;
+
+	if (q != NULL) {
+		if (seqno < Session->m_nbSourceSymbols) {
+			*begin = mod2qc_col_begin(q, seqno / q->z);
+			*end = mod2qc_col_end(q, seqno / q->z);
+		} else {
+			// staircase: the same row of the next block, if any
+			*begin = 0;
+			*end = (seqno + q->z < Session->m_nbSourceSymbols + Session->m_nbParitySymbols) ? 1 : 0;
+		}
+	} else {
+		col = GetMatrixCol(Session, seqno);
+		*begin = mod2csr_col_begin(Session->m_pchkCompressed, col);
+		*end = mod2csr_col_end(Session->m_pchkCompressed, col);
+	}
+}
+
+	static int
+ColRow (LDPCFecSession *Session, int seqno, int pos)
+{
+	mod2qc	*q = Session->m_qcMatrix;
+	int	row;
+
+	if (q != NULL) {
+		if (seqno < Session->m_nbSourceSymbols)
+			return mod2qc_col_row(q, pos, seqno % q->z);
+		return seqno - Session->m_nbSourceSymbols + q->z;	// staircase
+	}
+	row = mod2csr_row(Session->m_pchkCompressed, pos);
+	return (seqno >= Session->m_nbSourceSymbols &&
+		row == seqno - Session->m_nbSourceSymbols) ? -1 : row;
+}
+
+/*
+ * Specialized encoder registered for the parameters of a coding session
+ * (see ldpc_codec_registry.h), NULL if none. A profile whose matrix is
+ * not the one of the session is ignored.
+ */
+	static const ldpc_codec_profile*
+FindCodecProfile (LDPCFecSession *Session, int seed)
+{
+	const ldpc_codec_profile	*profile;
+	UINT32	hash = 0;
+	int	row, pos, end, seqno;
+
+	profile = ldpc_codec_find(Session->m_sessionType, Session->m_nbSourceSymbols,
+			Session->m_nbParitySymbols, Session->m_symbolSize,
+			(Session->m_sessionFlags & FLAG_PEG) ? PEG : Evenboth,
+			Session->m_leftDegree, seed,
+			(Session->m_sessionFlags & FLAG_NO4CYCLE) != 0);
+	if (profile == NULL)
+		return NULL;
+	for (row = 0; row < Session->m_nbParitySymbols; row++) {
+		RowRange(Session, row, &pos, &end);
+		for (; pos < end; pos++) {
+			if ((seqno = RowSymbol(Session, row, pos)) >= 0)
+				hash = ldpc_codec_hash(hash, row, seqno);
+		}
+	}
+	if (hash != profile->matrixHash) {
+		fprintf(stderr, "LDPCFecSession::InitSession: WARNING: the specialized encoder registered was generated from another matrix, ignored\n");
+		return NULL;
+	}
+	return profile;
+}
+
+/*
+ * Adds to the parity symbols the [from; to[ byte stripe of their symbols,
+ * buffers and lengths giving the buffer and length of each symbol of the
+ * canvas. The stripes of the parity symbols are cleared first.
+ */
+	static void
+EncodeStripe (
+		LDPCFecSession *Session,
+		UINT8**	buffers,
+		unsigned int*	lengths,
+		int	from,
+		int	to)
+{
+	mod2csr		*m = Session->m_pchkCompressed;
+	mod2qc		*q = Session->m_qcMatrix;
+	int		nbParity = Session->m_nbParitySymbols;
+	int		k = Session->m_nbSourceSymbols;
+	int		pos, end;	// positions of the entries in m
+	int		col, row, seqno, len;
+	UINT8		*src;
+
+	for (row = 0; row < nbParity; row++) {
+		len = (((int)lengths[k + row] < to) ? (int)lengths[k + row] : to) - from;
+		if (len > 0)
+			memset(buffers[k + row] + from, 0, len);
+	}
+	if (q != NULL) {
+		// Same with the computed entries: the successive source
+		// symbols of a block column are added to the successive rows
+		// of each of its circulants (modulo z), then each parity
+		// symbol to the one of the next block (staircase).
+		for (seqno = 0; seqno < k; seqno++) {
+			len = (((int)lengths[seqno] < to) ? (int)lengths[seqno] : to) - from;
+			if (len <= 0)
+				continue;
+			src = buffers[seqno] + from;
+			end = mod2qc_col_end(q, seqno / q->z);
+			for (pos = mod2qc_col_begin(q, seqno / q->z); pos < end; pos++) {
+				row = mod2qc_col_row(q, pos, seqno % q->z);
+				ldpc_xor(buffers[k + row] + from, src, len);
 			}
-			free(Session->m_parity_symbol_canvas);
 		}
-		if (Session->m_nbSymbols_in_equ != NULL) {
-			free(Session->m_nbSymbols_in_equ);
+		for (row = q->z; row < nbParity; row++) {
+			len = (((int)lengths[k + row - q->z] < to) ? (int)lengths[k + row - q->z] : to) - from;
+			if (len > 0)
+				ldpc_xor(buffers[k + row] + from, buffers[k + row - q->z] + from, len);
 		}
-		if (Session->m_nbEqu_for_parity != NULL) {
-			free(Session->m_nbEqu_for_parity);
+		return;
+	}
+	// 1- source symbols: the stripe of each of them is read once, and
+	// added to all the rows (parity symbols) of its column
+	for (col = nbParity; col < mod2csr_cols(m); col++) {
+		seqno = GetSymbolSeqno(Session, col);
+		len = (((int)lengths[seqno] < to) ? (int)lengths[seqno] : to) - from;
+		if (len <= 0)
+			continue;
+		src = buffers[seqno] + from;
+		end = mod2csr_col_end(m, col);
+		for (pos = mod2csr_col_begin(m, col); pos < end; pos++) {
+			row = mod2csr_row(m, pos);
+			ldpc_xor(buffers[k + row] + from, src, len);
 		}
-		if (Session->m_nb_unknown_symbols != NULL) {
-			free(Session->m_nb_unknown_symbols);
+	}
+	// 2- parity symbols depending on previous ones (STAIRS and
+	// TRIANGLE): in increasing order, so that they are complete when
+	// added
+	for (row = 0; row < nbParity; row++) {
+		end = mod2csr_row_end(m, row);
+		for (pos = mod2csr_row_begin(m, row); pos < end; pos++) {
+			col = mod2csr_col(m, pos);
+			if (col >= nbParity || col == row)
+				continue;
+			seqno = GetSymbolSeqno(Session, col);
+			len = (((int)lengths[seqno] < to) ? (int)lengths[seqno] : to) - from;
+			if (len <= 0)
+				continue;
+			ldpc_xor(buffers[k + row] + from, buffers[seqno] + from, len);
 		}
-		if (Session->m_nb_unknown_symbols_encoder != NULL) {
-			free(Session->m_nb_unknown_symbols_encoder);
+	}
+}
+
+/*
+ * Same as EncodeStripe, row by row: each parity symbol is the sum of the
+ * [from; to[ byte range of the symbols of its row, in increasing order so
+ * that the previous parity symbols are complete (STAIRS and TRIANGLE).
+ */
+	static void
+EncodeRows (
+		LDPCFecSession *Session,
+		UINT8**	buffers,
+		unsigned int*	lengths,
+		int	from,
+		int	to)
+{
+	int		k = Session->m_nbSourceSymbols;
+	int		pos, end;	// positions of the row entries (see RowRange)
+	int		row, seqno, len;
+
+	for (row = 0; row < Session->m_nbParitySymbols; row++) {
+		len = (((int)lengths[k + row] < to) ? (int)lengths[k + row] : to) - from;
+		if (len <= 0)
+			continue;
+		memset(buffers[k + row] + from, 0, len);
+		RowRange(Session, row, &pos, &end);
+		for (; pos < end; pos++) {
+			if ((seqno = RowSymbol(Session, row, pos)) < 0)
+				continue;
+			len = (((int)lengths[seqno] < to) ? (int)lengths[seqno] : to) - from;
+			if (len > 0)
+				ldpc_xor(buffers[k + row] + from, buffers[seqno] + from, len);
 		}
 	}
 }
 
 /******************************************************************************
- * Calculates the XOR sum of two symbols: to = to + from.
+ * SetParityCallback: Sets the function called by the streaming encoder.
  * => See header file for more informations.
  */
-	void
-AddToSymbol	(void	*to,
-		void	*from)
+	ldpc_error_status
+SetParityCallback (
+		LDPCFecSession *Session,
+		ldpc_parity_callback callback,
+		void* context)
+{
+	if (!(Session->m_sessionFlags & FLAG_CODER)) {
+		fprintf(stderr, "LDPCFecSession::SetParityCallback: ERROR: not a coding session!\n");
+		return LDPC_ERROR;
+	}
+	Session->m_parityCallback = callback;
+	Session->m_parityCallbackContext = context;
+	return LDPC_OK;
+}
+
+/*
+ * Adds a symbol to the accumulator of a parity symbol, and pushes the
+ * latter on the m_parityReady stack if this was the last symbol it was
+ * waiting for (only the parity symbol itself remains unknown in its row).
+ */
+	static ldpc_error_status
+AccumulateSymbol (
+		LDPCFecSession *Session,
+		int	row,
+		void*	symbol,
+		unsigned int	length)
+{
+	void	*acc = Session->m_parityAccumulators[row];
+
+	if (acc == NULL) {
+		if ((acc = AllocSymbol(Session)) == NULL)
+			return LDPC_ERROR;
+		Session->m_parityAccumulators[row] = acc;
+		Session->m_accumulatorLengths[row] = 0;
+		// empty, symbol is copied in it
+		AddToSymbolLength(GetBufferPtrOnly(Session, acc), &Session->m_accumulatorLengths[row],
+				symbol, length);
+	} else {
+		AddToSymbolLength(GetBuffer(Session, acc), &Session->m_accumulatorLengths[row],
+				symbol, length);
+	}
+	if (--Session->m_nb_unknown_symbols_encoder[row] == 1) {
+		Session->m_parityReady[Session->m_parityReady_nb++] = row;
+	}
+	return LDPC_OK;
+}
+
+/******************************************************************************
+ * AddSourceSymbol: Streaming encoder.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+AddSourceSymbol (
+		LDPCFecSession *Session,
+		int seqno,
+		void* symbol,
+		unsigned int length)
+{
+	void		*parity, *buffer;
+	int		pos, end;	// positions of the entries (see ColRange)
+	int		row, other;
+
+	if (!(Session->m_sessionFlags & FLAG_CODER) || Session->m_parityCallback == NULL ||
+			seqno < 0 || seqno >= Session->m_nbSourceSymbols ||
+			length > Session->m_symbolSize) {
+		fprintf(stderr, "LDPCFecSession::AddSourceSymbol: ERROR: not a coding session, no parity callback, or bad seqno %d / length %u!\n", seqno, length);
+		return LDPC_ERROR;
+	}
+	if (Session->m_sourceAdded[seqno]) {
+		// already there, nothing to do
+		return LDPC_OK;
+	}
+	Session->m_sourceAdded[seqno] = true;
+
+	// add it to all the rows of its column
+	ColRange(Session, seqno, &pos, &end);
+	for (; pos < end; pos++) {
+		if (AccumulateSymbol(Session, ColRow(Session, seqno, pos), GetBuffer(Session, symbol), length) != LDPC_OK)
+			return LDPC_ERROR;
+	}
+
+	// emit the parity symbols now complete, which may complete others
+	while (Session->m_parityReady_nb > 0) {
+		row = Session->m_parityReady[--Session->m_parityReady_nb];
+		parity = Session->m_parityAccumulators[row];
+		buffer = GetBuffer(Session, parity);
+		length = Session->m_accumulatorLengths[row];
+		Session->m_parityCallback(Session->m_parityCallbackContext, row, buffer, length);
+
+		// then add it to the rows depending on it (STAIRS, TRIANGLE)
+		ColRange(Session, Session->m_nbSourceSymbols + row, &pos, &end);
+		for (; pos < end; pos++) {
+			other = ColRow(Session, Session->m_nbSourceSymbols + row, pos);
+			if (other >= 0 &&
+			    AccumulateSymbol(Session, other, buffer, length) != LDPC_OK)
+				return LDPC_ERROR;
+		}
+		FreeSymbol(Session, parity);
+		Session->m_parityAccumulators[row] = NULL;
+	}
+	return LDPC_OK;
+}
+
+/* Minimum number of bytes encoded by a task of EncodeBlockParallel. */
+#define ENCODE_CHUNK_MIN	1024
+
+/* Work shared by the tasks of EncodeBlockParallel. */
+typedef struct {
+	LDPCFecSession	*session;
+	UINT8**		buffers; // buffer of each symbol
+	unsigned int*	lengths; // length of each symbol
+	int		maxLen;	// largest length
+	int		chunk;	// bytes per task
+	int		stripe;	// bytes per stripe
+	bool		byRows;	// row traversal instead of stripes
+} encode_job;
+
+/* A task encodes its chunk of the byte range, stripe by stripe. */
+	static void
+EncodeTask (void	*arg,
+	    int		taskIndex)
+{
+	encode_job	*job = (encode_job*)arg;
+	int		from = taskIndex * job->chunk;
+	int		end = (from + job->chunk < job->maxLen) ? from + job->chunk : job->maxLen;
+
+	if (job->byRows) {
+		if (from < end)
+			EncodeRows(job->session, job->buffers, job->lengths, from, end);
+		return;
+	}
+	for (; from < end; from += job->stripe) {
+		EncodeStripe(job->session, job->buffers, job->lengths, from,
+			     (from + job->stripe < end) ? from + job->stripe : end);
+	}
+}
+
+/* Arguments of a thread of the default executor. */
+typedef struct {
+	ldpc_task_func	task;
+	void*		arg;
+	int		taskIndex;
+} thread_task;
+
+	static void*
+ThreadMain (void	*arg)
+{
+	thread_task	*t = (thread_task*)arg;
+
+	t->task(t->arg, t->taskIndex);
+	return NULL;
+}
+
+/*
+ * Default executor: one thread per task, the calling thread running the
+ * first one. Tasks whose thread cannot be created are run by the calling
+ * thread.
+ */
+	static void
+ThreadExecutor (void		*context,
+		int		nbTasks,
+		ldpc_task_func	task,
+		void		*arg)
+{
+	pthread_t	*threads;
+	thread_task	*tasks;
+	bool		*started;
+	int		i;
+
+	threads = (pthread_t*)malloc(nbTasks * sizeof(pthread_t));
+	tasks = (thread_task*)malloc(nbTasks * sizeof(thread_task));
+	started = (bool*)calloc(nbTasks, sizeof(bool));
+	if (threads == NULL || tasks == NULL || started == NULL) {
+		for (i = 0; i < nbTasks; i++)
+			task(arg, i);
+		goto end;
+	}
+	for (i = 1; i < nbTasks; i++) {
+		tasks[i].task = task;
+		tasks[i].arg = arg;
+		tasks[i].taskIndex = i;
+		started[i] = (pthread_create(&threads[i], NULL, ThreadMain, &tasks[i]) == 0);
+	}
+	task(arg, 0);
+	for (i = 1; i < nbTasks; i++) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		else
+			task(arg, i);
+	}
+end:
+	free(threads);
+	free(tasks);
+	free(started);
+}
+
+/******************************************************************************
+ * EncodeBlock: Build all the parity symbols of a block at once.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+EncodeBlock (
+		LDPCFecSession *Session,
+		void* symbol_canvas[],
+		unsigned int symbol_lengths[])
+{
+	return EncodeBlockParallel(Session, symbol_canvas, symbol_lengths, 1, NULL, NULL);
+}
+
+/******************************************************************************
+ * EncodeBlockParallel: Build all the parity symbols of a block, with
+ * several threads.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+EncodeBlockParallel (
+		LDPCFecSession *Session,
+		void* symbol_canvas[],
+		unsigned int symbol_lengths[],
+		int nbThreads,
+		ldpc_executor_func executor,
+		void* executor_context)
 {
-	unsigned int		i;
-	LDPC_head data_head;
-	unsigned int 	data_size;
+	int		k = Session->m_nbSourceSymbols;
+	int		n = k + Session->m_nbParitySymbols;
+	const ldpc_codec_profile *codec = Session->m_codecProfile;
+	encode_job	job;
+	int		nbTasks, i, pos, end, seqno;
 
-	memcpy(&data_head, from, sizeof(data_head));
+	if (Session->m_pchkCompressed == NULL && Session->m_qcMatrix == NULL) {
+		fprintf(stderr, "LDPCFecSession::EncodeBlock: ERROR: not a coding session!\n");
+		return LDPC_ERROR;
+	}
+	job.lengths = (unsigned int*)malloc(n * sizeof(unsigned int));
+	job.buffers = (UINT8**)malloc(n * sizeof(UINT8*));
+	if (job.lengths == NULL || job.buffers == NULL) {
+		goto error;
+	}
+	job.session = Session;
+	job.maxLen = 0;
+	for (i = 0; i < n; i++) {
+		// buffers are resolved here once and for all, the tasks only
+		// see them
+		if (symbol_canvas[i] == NULL ||
+				(job.buffers[i] = (UINT8*)((i < k) ? GetBuffer(Session, symbol_canvas[i]) :
+						GetBufferPtrOnly(Session, symbol_canvas[i]))) == NULL ||
+				(symbol_lengths != NULL && i < k && symbol_lengths[i] > Session->m_symbolSize)) {
+			goto error;
+		}
+		if (i < k) {
+			job.lengths[i] = (symbol_lengths != NULL) ? symbol_lengths[i] : Session->m_symbolSize;
+			if (job.lengths[i] != Session->m_symbolSize)
+				codec = NULL;	// full length symbols only
+			continue;
+		}
+		if (codec != NULL) {
+			job.lengths[i] = Session->m_symbolSize;
+			continue;
+		}
+		// a parity symbol is as long as the longest symbol it depends
+		// on, the previous parity symbols being known (STAIRS and
+		// TRIANGLE)
+		job.lengths[i] = 0;
+		RowRange(Session, i - k, &pos, &end);
+		for (; pos < end; pos++) {
+			seqno = RowSymbol(Session, i - k, pos);
+			if (seqno >= 0 && job.lengths[seqno] > job.lengths[i])
+				job.lengths[i] = job.lengths[seqno];
+		}
+		if ((int)job.lengths[i] > job.maxLen)
+			job.maxLen = job.lengths[i];
+	}
+	if (codec != NULL) {
+		// specialized encoder, straight on the calling thread
+		codec->encode(job.buffers);
+		goto done;
+	}
+	if (nbThreads <= 0) {
+		nbThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	// Each task gets a chunk of the byte range, in whole cache lines.
+	// XOR being bytewise, the result does not depend on the split. Each
+	// task going through the whole matrix, chunks are not too small.
+	job.chunk = (job.maxLen + nbThreads - 1) / nbThreads;
+	job.chunk = (job.chunk + 63) & ~63;
+	if (job.chunk < ENCODE_CHUNK_MIN)
+		job.chunk = ENCODE_CHUNK_MIN;
+	nbTasks = (job.maxLen + job.chunk - 1) / job.chunk;
+	// the stripes of all the parity symbols of all the tasks must fit
+	// in (the last level) cache
+	job.stripe = ENCODE_CACHE_BUDGET / (Session->m_nbParitySymbols + 1) / (nbTasks > 0 ? nbTasks : 1);
+	job.stripe &= ~(ENCODE_STRIPE_MIN - 1);
+	if (job.stripe < ENCODE_STRIPE_MIN)
+		job.stripe = ENCODE_STRIPE_MIN;
+	// Stripes only pay off on blocks too large for the cache, and as
+	// long as the row traversal is miss bound: large symbols are
+	// streamed whole, short stripes of each would be slower.
+	job.byRows = (job.maxLen >= ENCODE_ROWS_SYMBOL ||
+		      (size_t)n * job.maxLen <= ENCODE_ROWS_BLOCK);
+
+	if (nbTasks == 1) {
+		EncodeTask(&job, 0);
+	} else if (nbTasks > 1) {
+		if (executor == NULL)
+			executor = ThreadExecutor;
+		executor(executor_context, nbTasks, EncodeTask, &job);
+	}
+done:
+	for (i = k; i < n; i++) {
+		StoreBuffer(Session, symbol_canvas[i]);
+	}
+	if (symbol_lengths != NULL) {
+		memcpy(symbol_lengths + k, job.lengths + k, (n - k) * sizeof(unsigned int));
+	}
+	free(job.lengths);
+	free(job.buffers);
+	return LDPC_OK;
 
-	if(data_head.type_flag)
-		data_size = data_head.longest_length - sizeof(data_head) + sizeof(unsigned short);
-	else
-		data_size = data_head.current_length - sizeof(data_head) + sizeof(unsigned short);
+error:
+	free(job.lengths);
+	free(job.buffers);
+	return LDPC_ERROR;
+}
 
-	UINT8		*t = (UINT8*)to;	// to pointer to 32-bit integers
-	UINT8		*f = (UINT8*)from;	// from pointer	to 32-bit integers
-	t += sizeof(data_head) - sizeof(unsigned short);
-	f += sizeof(data_head) - sizeof(unsigned short);
+/******************************************************************************
+ * Calculates the XOR sum of two symbols: to = to + from.
+ * => See header file for more informations.
+ */
+	void
+AddToSymbol	(void	*to,
+		void	*from,
+		unsigned int	length)
+{
+	// vectorized kernel, selected at startup (see ldpc_xor.h)
+	ldpc_xor((UINT8*)to, (UINT8*)from, length);
+}
 
-	for (i = data_size; i > 0; i--) {
-		*t ^= *f;
-		t++;
-		f++;
+/******************************************************************************
+ * AddToSymbolLength: XOR sum of two symbols of known lengths.
+ * => See header file for more informations.
+ */
+	void
+AddToSymbolLength	(void		*to,
+			unsigned int	*toLength,
+			void		*from,
+			unsigned int	fromLength)
+{
+	if (fromLength <= *toLength) {
+		ldpc_xor((UINT8*)to, (UINT8*)from, fromLength);
+	} else {
+		ldpc_xor((UINT8*)to, (UINT8*)from, *toLength);
+		// to is zero there
+		memcpy((UINT8*)to + *toLength, (UINT8*)from + *toLength,
+		       fromLength - *toLength);
+		*toLength = fromLength;
 	}
 }
 
+/******************************************************************************
+ * GetSymbolLength: Length of a symbol known to a decoding session.
+ * => See header file for more informations.
+ */
+	unsigned int
+GetSymbolLength	(LDPCFecSession *Session,
+		int	symbolSeqno)
+{
+	if (Session->m_symbolLengths == NULL || symbolSeqno < 0 ||
+			symbolSeqno >= Session->m_nbSourceSymbols + Session->m_nbParitySymbols)
+		return 0;
+	return Session->m_symbolLengths[symbolSeqno];
+}
+
 
 /******************************************************************************
  * BuildParitySymbol: Builds a new parity symbol.
@@ -188,33 +1047,52 @@ AddToSymbol	(void	*to,
 BuildParitySymbol (
 		LDPCFecSession *Session, 
 		void* symbol_canvas[],
+		unsigned int symbol_lengths[],
 		int paritySymbol_index,
 		void* paritySymbol)
 {
 	uintptr_t	*fec_buf;	// buffer for this parity symbol
 	uintptr_t	*to_add_buf;	// buffer for the  source.parity symbol to add
-	mod2entry	*e;
-	int seqno, k=0;
-	static int n=0;
+	int		begin, pos, end; // positions of the row entries (see RowRange)
+	int		seqno;
+	unsigned int	len, fec_len = 0;
 
-	fec_buf = (uintptr_t*)GetBufferPtrOnly(paritySymbol);
-
-	e = mod2sparse_first_in_row(Session->m_pchkMatrix, paritySymbol_index);
+	if (Session->m_pchkCompressed == NULL && Session->m_qcMatrix == NULL) {
+		fprintf(stderr, "LDPCFecSession::BuildParitySymbol: ERROR: not a coding session!\n");
+		return LDPC_ERROR;
+	}
+	fec_buf = (uintptr_t*)GetBufferPtrOnly(Session, paritySymbol);
 
-	while (!mod2sparse_at_end(e)) {
-		// paritySymbol_index in {0.. n-k-1} range, so this test is ok
-		if (e->col != paritySymbol_index) {
+	RowRange(Session, paritySymbol_index, &begin, &end);
+	// the parity symbol is as long as the longest symbol it depends on
+	for (pos = begin; pos < end; pos++) {
+		seqno = RowSymbol(Session, paritySymbol_index, pos);
+		if (seqno >= 0) {
+			len = (symbol_lengths != NULL) ? symbol_lengths[seqno] : Session->m_symbolSize;
+			if (len > Session->m_symbolSize) {
+				return LDPC_ERROR;
+			}
+			if (len > fec_len)
+				fec_len = len;
+		}
+	}
+	memset(fec_buf, 0, fec_len);
+	for (pos = begin; pos < end; pos++) {
+		seqno = RowSymbol(Session, paritySymbol_index, pos);
+		if (seqno >= 0) {
 			// don't add paritySymbol to itself
-			seqno = GetSymbolSeqno(Session, e->col);
-			//fprintf(stderr, "[%s:%d] total:%d now:%d seqno:%d, paritySymbol_index:%d, col:%d\n", __FILE__, __LINE__, n++, k++, seqno, paritySymbol_index, e->col);
 			to_add_buf = (uintptr_t*)
-				GetBuffer(symbol_canvas[seqno]);
+				GetBuffer(Session, symbol_canvas[seqno]);
 			if (to_add_buf == NULL) {
 				return LDPC_ERROR;
 			}
-			AddToSymbol(fec_buf, to_add_buf);
+			AddToSymbol(fec_buf, to_add_buf,
+				    (symbol_lengths != NULL) ? symbol_lengths[seqno] : Session->m_symbolSize);
 		}
-		e = mod2sparse_next_in_row(e);
+	}
+	StoreBuffer(Session, paritySymbol);
+	if (symbol_lengths != NULL) {
+		symbol_lengths[Session->m_nbSourceSymbols + paritySymbol_index] = fec_len;
 	}
 	return LDPC_OK;
 }
@@ -269,6 +1147,10 @@ IsDecodingComplete(LDPCFecSession *Session, void*	symbol_canvas[])
 		fprintf(stderr, "LDPCFecSession::IsDecodingComplete: ERROR: LDPC Session is NOT initialized!\n");
 		return false;
 	}
+	if (Session->m_knownSymbols != NULL) {
+		// the decoder keeps count
+		return (Session->m_nbMissingSources == 0);
+	}
 
 	for (i = Session->m_firstNonDecoded; i < Session->m_nbSourceSymbols; i++) {
 		if (symbol_canvas[i] == NULL) {
@@ -280,6 +1162,100 @@ IsDecodingComplete(LDPCFecSession *Session, void*	symbol_canvas[])
 	return true;
 }
 
+/******************************************************************************
+ * SetSymbolCallback: Sets the function called for each source symbol
+ * available.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+SetSymbolCallback (
+		LDPCFecSession *Session,
+		ldpc_symbol_callback callback,
+		void*	context,
+		bool	inOrder)
+{
+	if (!(Session->m_sessionFlags & FLAG_DECODER) || Session->m_nbReceived > 0) {
+		fprintf(stderr, "LDPCFecSession::SetSymbolCallback: ERROR: not a decoding session, or session already in use!\n");
+		return LDPC_ERROR;
+	}
+	Session->m_symbolCallback = callback;
+	Session->m_symbolCallbackContext = context;
+	Session->m_symbolCallbackInOrder = inOrder;
+	return LDPC_OK;
+}
+
+
+/******************************************************************************
+ * SourceSymbolAvailable: Gives a new source symbol to the application.
+ * => See header file for more informations.
+ */
+	void
+SourceSymbolAvailable (
+		LDPCFecSession *Session,
+		void*	symbol_canvas[],
+		int	symbolSeqno)
+{
+	int	i;
+
+	if (Session->m_symbolCallback == NULL) {
+		return;
+	}
+	if (!Session->m_symbolCallbackInOrder) {
+		Session->m_symbolCallback(Session->m_symbolCallbackContext, symbolSeqno,
+				GetBuffer(Session, symbol_canvas[symbolSeqno]),
+				Session->m_symbolLengths[symbolSeqno]);
+		return;
+	}
+	// the cursor only moves forward: each symbol is looked at once
+	// over the whole block
+	for (i = Session->m_nextDelivered; i < Session->m_nbSourceSymbols && symbol_canvas[i] != NULL; i++) {
+		Session->m_nextDelivered = i + 1;
+		Session->m_symbolCallback(Session->m_symbolCallbackContext, i,
+				GetBuffer(Session, symbol_canvas[i]),
+				Session->m_symbolLengths[i]);
+	}
+}
+
+/******************************************************************************
+ * GetKnownSymbols/IsSymbolKnown/GetNbMissingSourceSymbols: Symbols known to
+ * the decoder.
+ * => See header file for more informations.
+ */
+	const UINT64*
+GetKnownSymbols (LDPCFecSession *Session)
+{
+	return Session->m_knownSymbols;
+}
+
+	bool
+IsSymbolKnown (LDPCFecSession *Session, int symbolSeqno)
+{
+	if (Session->m_knownSymbols == NULL || symbolSeqno < 0 ||
+			symbolSeqno >= Session->m_nbSourceSymbols + Session->m_nbParitySymbols)
+		return false;
+	return ((Session->m_knownSymbols[symbolSeqno >> 6] >> (symbolSeqno & 63)) & 1) != 0;
+}
+
+	int
+GetNbMissingSourceSymbols (LDPCFecSession *Session)
+{
+	return Session->m_nbMissingSources;
+}
+
+
+/******************************************************************************
+ * MarkSymbolKnown: Records that a symbol is known to the decoder.
+ * => See header file for more informations.
+ */
+	void
+MarkSymbolKnown (LDPCFecSession *Session, int symbolSeqno)
+{
+	Session->m_knownSymbols[symbolSeqno >> 6] |= (UINT64)1 << (symbolSeqno & 63);
+	if (IsSourceSymbol(Session, symbolSeqno)) {
+		Session->m_nbMissingSources--;
+	}
+}
+
 //------------------------------------------------------------------------------
 // Inlines for all classes follow
 //------------------------------------------------------------------------------
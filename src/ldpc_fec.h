@@ -13,6 +13,11 @@
 #include "ldpc_create_pchk.h"
 #include "ldpc_types.h"
 #include "ldpc_matrix_sparse.h"
+#include "ldpc_matrix_compressed.h"
+#include "ldpc_pchk_cache.h"
+#include "ldpc_codec_registry.h"
+#include "ldpc_symbol_pool.h"
+#include "ldpc_xor.h"
 
 /****** CONSTANT AND CLASS DEFINITION *****************************************/
 
@@ -32,32 +37,116 @@ typedef enum {
 #define FLAG_DECODER	0x00000002
 #define FLAG_BOTH (FLAG_DECODER|FLAG_CODER)
 
+/**
+ * How the parity check matrix is built (default: evenly distributed
+ * random entries). Both ends must use the same flags, which change the
+ * code itself.
+ * FLAG_NO4CYCLE removes the cycles of length four through the source
+ * symbols, FLAG_PEG builds the matrix by progressive edge growth, which
+ * maximizes its girth (see ldpc_create_pchk.h). Both lower the number of
+ * symbols needed to decode, mostly for small blocks, at the price of a
+ * longer matrix creation (use a matrix file, see ldpc_pchk_file.h).
+ */
+#define FLAG_NO4CYCLE	0x00000010
+#define FLAG_PEG	0x00000020
+
+/*
+ * Symbols are plain buffers of m_symbolSize bytes, the codec knows nothing
+ * of the wire format (see ldpc_framing.h).
+ * Each symbol comes with a length: its bytes past this length are zero.
+ * They are skipped by XOR sums, and need not even be in the buffer: a
+ * short source symbol can be given as is, without padding.
+ */
+
+/**
+ * Function called by the streaming encoder (see AddSourceSymbol) for each
+ * parity symbol, as soon as it is complete.
+ * @param context	(IN) context given to SetParityCallback.
+ * @param paritySymbol_index (IN) index of the parity symbol in {0.. n-k-1}
+ *			range.
+ * @param paritySymbol	(IN) the parity symbol, only valid during the call.
+ * @param paritySymbol_length (IN) length of the parity symbol (bytes past
+ *			it are not initialized).
+ */
+typedef void (*ldpc_parity_callback) (void *context, int paritySymbol_index, void *paritySymbol, unsigned int paritySymbol_length);
+
+/**
+ * Function called by the decoder (see SetSymbolCallback) for each source
+ * symbol as soon as it is available, i.e. received or rebuilt.
+ * It is called in the middle of a decoding step: it must not call the
+ * decoder, apart from GetBuffer and GetSymbolLength.
+ * @param context	(IN) context given to SetSymbolCallback.
+ * @param symbolSeqno	(IN) source symbol sequence number in {0.. k-1}
+ *			range.
+ * @param symbol	(IN) buffer of the symbol, which remains valid as
+ *			long as the symbol is in symbol_canvas.
+ * @param symbolLength	(IN) length of the symbol (see GetSymbolLength).
+ */
+typedef void (*ldpc_symbol_callback) (void *context, int symbolSeqno, void *symbol, unsigned int symbolLength);
+
+/**
+ * External memory management (see SetMemoryCallbacks): the symbols
+ * allocated by the session come from the application instead of the
+ * session's pool, e.g. from a hugepage arena, a shared memory ring or an
+ * mmap'ed file.
+ * The symbols are then handles, which need not be buffers: the session
+ * only accesses their content through GetBuffer/GetBufferPtrOnly. This
+ * holds for all the symbols exchanged with the session (symbol canvas,
+ * received symbols...), whoever allocated them. All the callbacks get the
+ * context given to SetMemoryCallbacks as first argument.
+ */
 typedef struct {
-	unsigned int 	type_flag:1;
-	unsigned int 	group_id:31;
-	unsigned int 	sequence_no;
-	unsigned short 	total_data;
-	unsigned short 	total_fec;
-	unsigned short 	longest_length;
-	unsigned short 	current_length;
-}LDPC_head;
+	// Allocates a symbol of size bytes, NULL if no memory is left.
+	void*	(*allocSymbol) (void *context, unsigned int size);
+	// Releases a symbol obtained from allocSymbol or decodedSymbol.
+	void	(*freeSymbol) (void *context, void *symbol);
+	// Optional: returns the buffer of a symbol, its content being read
+	// (and possibly updated). The buffer remains valid until the symbol
+	// is released. If NULL, the handle is the buffer.
+	void*	(*getData) (void *context, void *symbol);
+	// Optional: same as getData, the content of the buffer being about
+	// to be overwritten: it need not be up to date. If NULL, getData is
+	// used.
+	void*	(*getDataPtrOnly) (void *context, void *symbol);
+	// Optional: called once the session is done writing a symbol that
+	// is kept (rebuilt or stored symbol, parity symbol built).
+	void	(*storeData) (void *context, void *symbol);
+	// Optional: allocates the symbol in which the decoder stores source
+	// symbol symbolSeqno (received with store_symbol set, or rebuilt),
+	// e.g. at its place in the output. If NULL, allocSymbol is used and
+	// rebuilt symbols are not copied (see DecodingWithOwnedSymbol).
+	void*	(*decodedSymbol) (void *context, unsigned int size, int symbolSeqno);
+} ldpc_memory_callbacks;
 
 typedef struct {
 	bool	m_initialized;	// is TRUE if session has been initialized
 	int	m_sessionFlags;	// Mask containing session flags
 	// (FLAG_CODER, FLAG_DECODER, ...)
 	SessionType	m_sessionType;	// Type of the session. Can be one of
-	// LDGM, LDPC STAIRS, and
-	// LDPC TRIANGLE.
+	// LDGM, LDPC STAIRS, LDPC TRIANGLE and
+	// quasi-cyclic LDPC STAIRS.
 
 	unsigned int	m_symbolSize;	// Size of symbols in BYTES
 
 	int	m_nbSourceSymbols;	// number fo source symbol (K)
 	int	m_nbParitySymbols;	// number of parity symbol (=m_nbCheck)
 
-	mod2sparse*	m_pchkMatrix;	// Parity Check matrix in sparse mode 
-	// format. This matrix is also used as
+	pchk_cache_entry* m_pchkCacheEntry; // Reference to the shared
+	// parity check matrix in the matrix cache.
+	mod2csr*	m_pchkCompressed; // Parity Check matrix, in compressed
+	// format. It is shared by all the sessions
+	// using the same parameters and must NEVER
+	// be modified. This matrix is also used as
 	// a generator matrix in LDGM-* modes.
+	mod2qc*		m_qcMatrix;	// Coder of a TypeQCSTAIRS session:
+	// description of the matrix, whose
+	// entries are computed rather than read
+	// (m_pchkCompressed is then NULL for a
+	// coding only session), NULL otherwise.
+	mod2sparse*	m_pchkMatrix;	// Decoder only: private working copy of
+	// the Parity Check matrix in sparse mode
+	// format, whose entries are deleted as
+	// decoding progresses.
 
 	int		m_leftDegree;	// Number of equations per data symbol
 
@@ -65,32 +154,86 @@ typedef struct {
 	int*		m_nb_unknown_symbols_encoder; // Array: nb unknown symbols
 	// per check node. Used during per column
 	// encoding.
+	void**		m_parityAccumulators; // Array: partial sums of the
+	// parity symbols being built by
+	// AddSourceSymbol, NULL if none yet.
+	unsigned int*	m_accumulatorLengths; // Array: length of each
+	// parity accumulator.
+	bool*		m_sourceAdded;	// Array: true for the source symbols
+	// already given to AddSourceSymbol.
+	int*		m_parityReady;	// Stack of the parity symbols complete
+	// but not emitted yet.
+	int		m_parityReady_nb;
+	ldpc_parity_callback m_parityCallback; // Called for each parity
+	// symbol built by AddSourceSymbol.
+	void*		m_parityCallbackContext;
+	const ldpc_codec_profile* m_codecProfile; // Specialized encoder
+	// registered for the parameters of the
+	// session, used by EncodeBlock, or NULL.
 
 	// Decoder specific...
 	void**		m_checkValues;	// Array: current check-nodes value.
 	// Each entry is the sum (XOR) of some
 	// or all of the known symbols in this
 	// equation.
+	unsigned int*	m_checkLengths;	// Array: length of each check-node
+	// value (longest of the symbols added).
+	unsigned int*	m_symbolLengths; // Array: length of the n symbols
+	// known to the decoder (received or
+	// rebuilt), see GetSymbolLength.
 	int*		m_nbSymbols_in_equ;// Array: nb of variables per check
 	// node, ie. per equation
 	int		m_firstNonDecoded; // index of first symbol not decoded.
 	// Used to know whether decoding is
-	// finished or not.
+	// finished or not, without a decoder.
+	int		m_nbMissingSources; // number of source symbols neither
+	// received nor rebuilt yet.
+	UINT64*		m_knownSymbols;	// Bitmap of the n symbols received or
+	// rebuilt (bit i%64 of word i/64 for
+	// symbol i).
 	int*		m_nb_unknown_symbols; // Array: nb unknown symbols per check node
 	int*		m_nbEqu_for_parity; // Array: nb of equations where
 	// each parity symbol is included
 	void**		m_parity_symbol_canvas; //Canvas of stored parity symbols.
+	int*		m_checkOfDeg1;	// Array: worklist of check nodes of
+	// degree one, waiting to be decoded.
+	// A check node enters it at most once,
+	// so m_nbParitySymbols entries are enough.
+	int		m_checkOfDeg1_nb; // number of entries in the worklist
+	symbol_pool*	m_symbolPool;	// Pool of symbol buffers used for partial
+	// sums, stored parity symbols and source
+	// symbols stored by the decoder, and for
+	// the parity accumulators of the encoder.
+	bool		m_symbolPoolOwned; // true if m_symbolPool is private to
+	// the session, false if shared.
+	ldpc_memory_callbacks m_memoryCallbacks; // External memory
+	// management, used instead of m_symbolPool
+	// if allocSymbol is set.
+	void**		m_ownedSourceSymbols; // Array: source symbols stored
+	// by the decoder in symbol_canvas, which
+	// belong to the session.
+	int		m_nbReceived;	// number of fresh symbols given to the
+	// decoder so far
+	ldpc_symbol_callback m_symbolCallback; // Called for each source
+	// symbol available.
+	void*		m_symbolCallbackContext;
+	bool		m_symbolCallbackInOrder; // if true, source symbols
+	// are given to m_symbolCallback in order.
+	int		m_nextDelivered; // in order delivery: first source
+	// symbol not given to m_symbolCallback yet.
+	bool		m_mlDecoding;	// if true, switch to maximum likelihood
+	// decoding when the iterative decoder is
+	// stuck and at least k symbols arrived
+	int		m_mlRetryAt;	// after a failed ML decoding, number
+	// of fresh symbols needed (m_nbReceived)
+	// before it can succeed
 
-#if 0
-	uintptr_t* 	m_builtSymbol; 	// symbol built by decoder, used for 
-	// recursive calls of DecodingStepWithSymbol
-#endif
 	bool		m_triangleWithSmallFECRatio;
 	// with LDGM Triangle and a small FEC
 	// ratio (ie. < 2), some specific
 	// behaviors are needed...
 
-	void*		m_context_4_callback; // used by callback functions
+	void*		m_context_4_callback; // used by m_memoryCallbacks
 }LDPCFecSession;
 
 
@@ -103,10 +246,15 @@ typedef struct {
  *			returned.
  * @param symbolSize	(IN) symbol size in bytes. It does NOT need to be
  *			multiple of 4, any value is accepted.
- * @param flags		(IN) session flags (FLAG_CODER, FLAG_DECODER, ...).
+ * @param flags		(IN) session flags (FLAG_CODER, FLAG_DECODER, ...),
+ *			possibly with FLAG_NO4CYCLE and/or FLAG_PEG.
  * @param seed		(IN) seed used to build the parity check matrix (H).
  * @param codecType	(IN) Type of codec algorithm and matrix to use.
- *			Can be on of TypeLDGM, TypeSTAIRS, or TypeTRIANGLE.
+ *			Can be on of TypeLDGM, TypeSTAIRS, TypeTRIANGLE, or
+ *			TypeQCSTAIRS. A TypeQCSTAIRS coder does not need
+ *			the matrix itself, only a compact description of
+ *			it (see CreateQCPchkMatrix): FLAG_NO4CYCLE and
+ *			FLAG_PEG do not apply.
  * @param leftDegree	(IN) number of equations in which a symbol is involved.
  *			3 (default) is the optimal value for TypeSTAIRS
  *			and TypeTRIANGLE codes, DO NOT change.
@@ -131,6 +279,21 @@ ldpc_error_status InitSession  (
 void EndSession (LDPCFecSession *Session);
 
 
+/**
+ * ResetSession: Makes an initialized session ready for a new block with
+ * the same parameters, without building the matrix nor allocating the
+ * tables again. The working copy of the matrix and the per-check counters
+ * are restored in a single pass, and all the symbols of the previous
+ * block are given back to the pool (or to the freeSymbol callback): the
+ * symbol_canvas used so far must be cleared by the caller before being
+ * reused, since it may point to such symbols.
+ * The settings of the session (symbol pool, memory, symbol and parity
+ * callbacks, ML decoding) are kept.
+ * @return		Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status ResetSession (LDPCFecSession *Session);
+
+
 /**
  * IsInitialized: Check if the LDPC session has been initialized.
  * @return	  TRUE if the session is ready and initialized, FALSE if not.
@@ -143,6 +306,11 @@ bool IsInitialized (LDPCFecSession *Session);
  * @param symbol_canvas	(IN)	Array of source and parity symbols.
  *				This is a table of n pointers to buffers
  *				containing the source and parity symbols.
+ * @param symbol_lengths (IN-OUT) Array of the n symbol lengths, or NULL
+ *				if all the symbols are m_symbolSize bytes
+ *				long. The lengths of the symbols the parity
+ *				symbol depends on are read, and the length
+ *				of the parity symbol built is stored.
  * @param paritySymbol_index	(IN)	Index of parity symbol to build in {0.. n-k-1}
  *				range (!)
  * @param paritySymbol	(IN-OUT) Pointer to the parity symbol buffer that will
@@ -154,10 +322,135 @@ bool IsInitialized (LDPCFecSession *Session);
 ldpc_error_status BuildParitySymbol (
 		LDPCFecSession *Session, 
 		void*		symbol_canvas[],
+		unsigned int	symbol_lengths[],
 		int		paritySymbol_index,
 		void*		paritySymbol); 
 
 
+/**
+ * Sets the function called by the streaming encoder for each parity
+ * symbol (see AddSourceSymbol).
+ * @param callback	(IN)	function to call.
+ * @param context	(IN)	first argument of callback.
+ * @return			Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status SetParityCallback (
+		LDPCFecSession *Session,
+		ldpc_parity_callback callback,
+		void*		context);
+
+/**
+ * Streaming encoder: adds a source symbol to the parity symbols depending
+ * on it. Source symbols can be given in any order, as soon as they are
+ * available (e.g. right after being sent), and need not be kept after the
+ * call. Each parity symbol is given to the parity callback as soon as all
+ * the symbols it depends on are known (for STAIRS and TRIANGLE this
+ * includes previous parity symbols, emitted first): the last one is
+ * emitted by the call adding the last source symbol.
+ * Parity symbols are the same as with BuildParitySymbol.
+ * @param seqno		(IN)	source symbol sequence number in {0.. k-1}
+ *				range.
+ * @param symbol	(IN)	the source symbol.
+ * @param length	(IN)	length of the source symbol.
+ * @return			Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status AddSourceSymbol (
+		LDPCFecSession *Session,
+		int		seqno,
+		void*		symbol,
+		unsigned int	length);
+
+
+/**
+ * Cache budget for the parity symbol stripes of EncodeBlock, and minimum
+ * stripe size, in bytes. Both can be tuned at build time.
+ * Stripes of less than a page make EncodeBlock TLB bound, and on large
+ * symbols streaming whole symbols beats L2 sized stripes: the default
+ * budget is sized for the last level cache.
+ */
+#ifndef ENCODE_CACHE_BUDGET
+#define ENCODE_CACHE_BUDGET	(32 * 1024 * 1024)
+#endif
+#ifndef ENCODE_STRIPE_MIN
+#define ENCODE_STRIPE_MIN	4096
+#endif
+
+/**
+ * EncodeBlock goes through the matrix row by row, as BuildParitySymbol,
+ * rather than in stripes, when the symbols are at least ENCODE_ROWS_SYMBOL
+ * bytes long or the whole block is at most ENCODE_ROWS_BLOCK bytes long.
+ * Both can be tuned at build time.
+ */
+#ifndef ENCODE_ROWS_SYMBOL
+#define ENCODE_ROWS_SYMBOL	(8 * 1024)
+#endif
+#ifndef ENCODE_ROWS_BLOCK
+#define ENCODE_ROWS_BLOCK	(1024 * 1024)
+#endif
+
+/**
+ * Build all the parity symbols of a block at once.
+ * The result is the same as calling BuildParitySymbol for each parity
+ * symbol, in increasing index order, but the symbols are processed in byte
+ * stripes sized so that the stripes of all the parity symbols stay in
+ * cache: each stripe of a source symbol is read once, and added to all the
+ * parity symbols that depend on it. Then the parity symbols that depend on
+ * previous ones (STAIRS and TRIANGLE) are completed, stripe by stripe.
+ * Small blocks and large symbols, for which stripes do not pay off, are
+ * encoded row by row instead (see ENCODE_ROWS_SYMBOL).
+ * If a specialized encoder is registered for the parameters of the
+ * session (see ldpc_codec_registry.h) and all the source symbols are
+ * full length, it builds the parity symbols instead.
+ * @param symbol_canvas	(IN-OUT) Array of source and parity symbols.
+ *				This is a table of n pointers to buffers:
+ *				the k source symbols, followed by the n-k
+ *				parity symbols to build (they need not be
+ *				cleared).
+ * @param symbol_lengths (IN-OUT) Same as for BuildParitySymbol: the
+ *				lengths of all the parity symbols are
+ *				stored.
+ * @return			Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status EncodeBlock (
+		LDPCFecSession *Session,
+		void*		symbol_canvas[],
+		unsigned int	symbol_lengths[]);
+
+
+/**
+ * Task run by an executor: taskIndex is in {0.. nbTasks-1} range.
+ */
+typedef void (*ldpc_task_func) (void *arg, int taskIndex);
+
+/**
+ * Executor: runs task(arg, i) for each i in {0.. nbTasks-1} range,
+ * possibly in parallel, and returns once all of them are done.
+ * @param context	(IN) executor_context given to EncodeBlockParallel.
+ */
+typedef void (*ldpc_executor_func) (void *context, int nbTasks, ldpc_task_func task, void *arg);
+
+/**
+ * Same as EncodeBlock, the byte range of the symbols being split into
+ * nbThreads chunks encoded in parallel. XOR sums being bytewise, the
+ * result is the same as with serial encoding.
+ * @param nbThreads	(IN)	Number of parallel tasks, or 0 for one per
+ *				online CPU.
+ * @param executor	(IN)	Function running the tasks, e.g. on the
+ *				application thread pool, or NULL to run them
+ *				on nbThreads-1 new threads plus the calling
+ *				one.
+ * @param executor_context (IN)	First argument of executor.
+ * @return			Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status EncodeBlockParallel (
+		LDPCFecSession *Session,
+		void*		symbol_canvas[],
+		unsigned int	symbol_lengths[],
+		int		nbThreads,
+		ldpc_executor_func executor,
+		void*		executor_context);
+
+
 /**
  * Perform a new decoding step thanks to the newly received symbol.
  * @param symbol_canvas	(IN-OUT) Global array of received or rebuilt source
@@ -167,8 +460,14 @@ ldpc_error_status BuildParitySymbol (
  * 				the first call to this function. It will be
  * 				automatically updated, with pointers to
  * 				symbols received or decoded, by this function.
+ *				Buffers stored here by the decoder (copies
+ *				of received symbols and rebuilt symbols)
+ *				belong to the session: they must NOT be
+ *				freed, and remain valid until EndSession.
  * @param new_symbol	(IN)	Pointer to the buffer containing the new symbol.
  * @param new_symbol_seqno	(IN)	New symbol's sequence number in {0.. n-1} range.
+ * @param new_symbol_length	(IN)	Length of the new symbol: only this many
+ *				bytes are read from new_symbol.
  * @param store_symbol	(IN)	true if the function needs to allocate memory,
  *				copy the symbol content in it, and call
  *				any required callback.
@@ -182,6 +481,7 @@ ldpc_error_status DecodingWithSymbol (
 		void*	symbol_canvas[],
 		void*	new_symbol,
 		int	new_symbol_seqno,
+		unsigned int	new_symbol_length,
 		bool	store_symbol);
 
 
@@ -198,17 +498,206 @@ ldpc_error_status DecodingWithSymbol (
  * 				symbols received or decoded, by this function.
  * @param new_symbol	(IN)	Pointer to the buffer containing the new symbol.
  * @param new_symbol_seqno	(IN)	New symbol's sequence number in {0.. n-1} range.
+ * @param new_symbol_length	(IN)	Length of the new symbol.
  * @return			Completion status (LDPC_OK or LDPC_ERROR).
  */
 ldpc_error_status DecodingStepWithSymbol (
 		LDPCFecSession *Session, 
 		void*	symbol_canvas[],
 		void*	new_symbol,
-		int	new_symbol_seqno);
+		int	new_symbol_seqno,
+		unsigned int	new_symbol_length);
+
+
+/**
+ * Perform a new decoding step thanks to the newly received symbol, the
+ * buffer holding it being given to the decoder instead of being copied.
+ * The application receives symbols directly in buffers of the session's
+ * pool (see AllocSymbol, or SetSymbolPool to use its own pool), which then
+ * belong to the session whatever the outcome: a source symbol is stored
+ * as is in symbol_canvas (and released in EndSession), a parity symbol is
+ * kept as is or given back to the pool once added to the equations, and a
+ * symbol already known is given back at once.
+ * @param symbol_canvas	(IN-OUT) Same as for DecodingWithSymbol.
+ * @param new_symbol	(IN)	Buffer obtained with AllocSymbol, holding the
+ *				new symbol. It must not be used any more by
+ *				the caller.
+ * @param new_symbol_seqno	(IN)	New symbol's sequence number in {0.. n-1} range.
+ * @param new_symbol_length	(IN)	Length of the new symbol.
+ * @return			Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status DecodingWithOwnedSymbol (
+		LDPCFecSession *Session, 
+		void*	symbol_canvas[],
+		void*	new_symbol,
+		int	new_symbol_seqno,
+		unsigned int	new_symbol_length);
+
+
+/**
+ * Length of a symbol known to a decoding session, i.e. received or
+ * rebuilt: the bytes of a rebuilt source symbol past this length are zero,
+ * but may not be initialized in its buffer.
+ * @param symbolSeqno	(IN) symbol sequence number in {0.. n-1} range.
+ * @return		length of the symbol, 0 if unknown.
+ */
+unsigned int GetSymbolLength (LDPCFecSession *Session, int symbolSeqno);
 
 
 /**
- * Checks if all DATA symbols have been received/rebuilt.
+ * Bitmap of the symbols known to a decoding session, i.e. received or
+ * rebuilt: symbol i is known if bit (i % 64) of word (i / 64) is set.
+ * This gives for instance the source symbols to ask again for in a NACK.
+ * Parity symbols no longer useful to the decoder may be missing from it.
+ * @return		(n + 63) / 64 words, read only and updated as
+ *			decoding goes, valid until EndSession. NULL if this
+ *			is not a decoding session.
+ */
+const UINT64* GetKnownSymbols (LDPCFecSession *Session);
+
+/**
+ * Returns true if a symbol is known to a decoding session (see
+ * GetKnownSymbols).
+ * @param symbolSeqno	(IN) symbol sequence number in {0.. n-1} range.
+ */
+bool IsSymbolKnown (LDPCFecSession *Session, int symbolSeqno);
+
+/**
+ * Returns the number of source symbols a decoding session still misses,
+ * 0 once decoding is complete.
+ */
+int GetNbMissingSourceSymbols (LDPCFecSession *Session);
+
+/**
+ * Records that a symbol is now known to the decoder. Used internally by
+ * the decoders, before storing a source symbol in symbol_canvas.
+ * @param symbolSeqno	(IN) symbol sequence number in {0.. n-1} range.
+ */
+void MarkSymbolKnown (LDPCFecSession *Session, int symbolSeqno);
+
+
+/**
+ * Makes a decoding session use a shared symbol pool instead of its own.
+ * Must be called after InitSession and before the first decoding step.
+ * The pool buffers must be at least as large as the session symbols, and
+ * the pool must outlive the session (symbols are given back to it in
+ * EndSession).
+ * @param pool		(IN)	pool to use.
+ * @return		Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status SetSymbolPool (LDPCFecSession *Session, symbol_pool *pool);
+
+
+/**
+ * Makes a session allocate its symbols with the application's callbacks
+ * instead of its symbol pool. Must be called after InitSession and before
+ * the first symbol is given to the session.
+ * @param callbacks	(IN)	callbacks to use, copied by the session:
+ *				allocSymbol and freeSymbol are mandatory.
+ * @param context	(IN)	first argument of the callbacks.
+ * @return		Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status SetMemoryCallbacks (
+		LDPCFecSession *Session,
+		const ldpc_memory_callbacks *callbacks,
+		void*	context);
+
+
+/**
+ * Gets a symbol from the session's pool, or its allocSymbol callback
+ * (content undefined).
+ * Used internally for all the symbols allocated by the decoder, and by the
+ * application for the symbols given to DecodingWithOwnedSymbol.
+ * @return		the buffer, or NULL if no memory is left.
+ */
+void* AllocSymbol (LDPCFecSession *Session);
+
+/**
+ * Gives back a symbol obtained with AllocSymbol.
+ */
+void FreeSymbol (LDPCFecSession *Session, void *symbol);
+
+/**
+ * Gets the symbol in which the decoder stores a source symbol, from the
+ * decodedSymbol callback if any, otherwise from AllocSymbol. It is given
+ * back with FreeSymbol.
+ * @param symbolSeqno	(IN) source symbol sequence number.
+ * @return		the symbol, or NULL if no memory is left.
+ */
+void* AllocDecodedSymbol (LDPCFecSession *Session, int symbolSeqno);
+
+
+/**
+ * Sets the function called by the decoder for each source symbol as soon
+ * as it is available, so that the application can process it without
+ * waiting for the whole block.
+ * Must be called after InitSession and before the first decoding step.
+ * @param callback	(IN)	function to call, NULL for none.
+ * @param context	(IN)	first argument of callback.
+ * @param inOrder	(IN)	if false, each symbol is given as soon as it
+ *				is received or rebuilt. If true, source symbols
+ *				are given in sequence number order: a symbol is
+ *				given once all the previous ones are available,
+ *				each decoding step giving the longest prefix of
+ *				the block available so far.
+ * @return			Completion status (LDPC_OK or LDPC_ERROR).
+ */
+ldpc_error_status SetSymbolCallback (
+		LDPCFecSession *Session,
+		ldpc_symbol_callback callback,
+		void*	context,
+		bool	inOrder);
+
+/**
+ * Gives a source symbol just stored in symbol_canvas to the callback set
+ * with SetSymbolCallback, if any, or the symbols it makes available in
+ * order. Used internally by the decoders.
+ * @param symbolSeqno	(IN) source symbol sequence number.
+ */
+void SourceSymbolAvailable (
+		LDPCFecSession *Session,
+		void*	symbol_canvas[],
+		int	symbolSeqno);
+
+
+/**
+ * Enables or disables automatic maximum likelihood (ML) decoding.
+ * When enabled, each time the iterative decoder is stuck after at least k
+ * fresh symbols have been given to the decoder, DecodingWithML is tried
+ * before returning from DecodingStepWithSymbol. After a failed attempt,
+ * it is not tried again before as many new symbols have arrived as the
+ * system lacked independent equations. Disabled by default.
+ * @param enable	(IN)	true to enable ML decoding.
+ */
+void SetMLDecoding (LDPCFecSession *Session, bool enable);
+
+
+/**
+ * Maximum likelihood decoding of the source symbols the iterative decoder
+ * could not rebuild. The linear system made of the remaining equations is
+ * solved by structured Gaussian elimination: the sparse part is solved as
+ * far as possible by the same process as iterative decoding, a few
+ * symbols being "inactivated" each time it is stuck, and only the system
+ * over these inactivated symbols is solved with a dense bit-packed GF(2)
+ * matrix.
+ * The system is first solved on the matrix alone, so that nothing is
+ * changed (and no symbol processed) if it has no unique solution.
+ * Can be called at any time on a decoding session, in addition to or
+ * instead of automatic ML decoding (see SetMLDecoding).
+ * @param symbol_canvas	(IN-OUT) Same as for DecodingStepWithSymbol. Rebuilt
+ *				source symbols are allocated and stored here.
+ * @return			LDPC_OK if all source symbols are now available,
+ *				LDPC_ERROR if the system has no unique solution
+ *				yet (more symbols are needed) or in case of error.
+ */
+ldpc_error_status DecodingWithML (
+		LDPCFecSession *Session, 
+		void*	symbol_canvas[]);
+
+
+/**
+ * Checks if all DATA symbols have been received/rebuilt. This is O(1) for
+ * a decoding session, which counts the missing source symbols.
  * @param symbol_canvas	(IN)	Array of received/rebuilt source symbols.
  * @return			TRUE if all DATA symbols have been received
  * 				or decoded.
@@ -249,9 +738,25 @@ int	GetSymbolSeqno	(LDPCFecSession *Session, int matrixCol);
  * Calculates the XOR sum of two symbols: to = to + from.
  * @param to		(IN/OUT) source symbol
  * @param from		(IN/OUT) symbol added to the source symbol
+ * @param length	(IN) number of bytes added
  */
 void	AddToSymbol	(void	*to,
-		void	*from);
+		void	*from,
+		unsigned int	length);
+
+/**
+ * Calculates the XOR sum of two symbols of known lengths: to = to + from.
+ * Only the bytes below the longest of the two lengths are touched, the
+ * ones of from past *toLength being copied rather than added.
+ * @param to		(IN/OUT) symbol
+ * @param toLength	(IN/OUT) length of to, set to the length of the sum
+ * @param from		(IN) symbol added to to
+ * @param fromLength	(IN) length of from
+ */
+void	AddToSymbolLength	(void		*to,
+			unsigned int	*toLength,
+			void		*from,
+			unsigned int	fromLength);
 
 
 /**
@@ -278,35 +783,51 @@ GetMaxN ()
 /**
  * Get the data buffer associated to a symbol stored in the
  * symbol_canvas[] / m_parity_symbol_canvas[] / m_checkValues[] tables.
- * This function is usefull in EXTERNAL_MEMORY_MGMT_SUPPORT mode
- * when a the Alloc/Get/Store/Free callbacks are used, but it does
- * nothing in other mode. This is due to the fact that with these
- * callbacks, the various canvas do not point to data buffers but
- * to intermediate structures, and therefore accessing the associated
- * buffer needs extra processing.
+ * With external memory management (see SetMemoryCallbacks), the various
+ * canvas do not point to data buffers but to handles given by the
+ * application, and accessing the associated buffer goes through its
+ * getData callback, which makes sure the data is available and up to
+ * date. Otherwise this function does nothing.
  * @param symbol	(IN) pointer stored in the various canvas
  * @return		associated buffer
  */
 	static inline void*
-GetBuffer	(void	*symbol)
+GetBuffer	(LDPCFecSession *Session,
+		 void	*symbol)
 {
-	return symbol;		// nothing to do here
+	if (Session->m_memoryCallbacks.getData == NULL)
+		return symbol;
+	return Session->m_memoryCallbacks.getData(Session->m_context_4_callback, symbol);
 }
 
 /**
- * Same as GetBuffer, except that this call does not use the
- * GetData_callback but GetDataPtrOnly_callback instead.
- * For instance, in EXTERNAL_MEMORY_MGMT_SUPPORT, it will not
- * make sure that data is actually available and up-to-date,
- * perhaps because this is a destination buffer in a memcpy
- * that has just been allocated!
+ * Same as GetBuffer, except that this call does not use the getData
+ * callback but getDataPtrOnly instead: it does not make sure that data is
+ * actually available and up to date, perhaps because this is a destination
+ * buffer in a memcpy that has just been allocated!
  * @param symbol	(IN) pointer stored in the various canvas
  * @return		associated buffer
  */
 	static inline void*
-GetBufferPtrOnly	(void	*symbol)
+GetBufferPtrOnly	(LDPCFecSession *Session,
+			 void	*symbol)
+{
+	if (Session->m_memoryCallbacks.getDataPtrOnly == NULL)
+		return GetBuffer(Session, symbol);
+	return Session->m_memoryCallbacks.getDataPtrOnly(Session->m_context_4_callback, symbol);
+}
+
+/**
+ * Tells the application (storeData callback, if any) that the content of
+ * a symbol kept by the session has been written.
+ * @param symbol	(IN) pointer stored in the various canvas
+ */
+	static inline void
+StoreBuffer	(LDPCFecSession *Session,
+		 void	*symbol)
 {
-	return symbol;		// nothing to do here
+	if (Session->m_memoryCallbacks.storeData != NULL)
+		Session->m_memoryCallbacks.storeData(Session->m_context_4_callback, symbol);
 }
 
 #endif /* } LDPC_FEC_H */
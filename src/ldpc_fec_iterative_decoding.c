@@ -4,6 +4,47 @@
 /*
  * Decoder using the Iterative Decoding Algorithm.
  */
+/******************************************************************************
+ * IsAlreadyProcessed: true if this symbol has already been received or
+ * decoded, or is no longer involved in any equation (step 0 of decoding).
+ */
+	static bool
+IsAlreadyProcessed (
+		LDPCFecSession *Session,
+		int	symbol_seqno)
+{
+	return (((Session->m_knownSymbols[symbol_seqno >> 6] >> (symbol_seqno & 63)) & 1)
+			|| (mod2sparse_last_in_col(Session->m_pchkMatrix, GetMatrixCol(Session, symbol_seqno))->row < 0));
+}
+
+
+/******************************************************************************
+ * TrimmedLength: Length of a symbol once its trailing zero bytes are removed.
+ * A parity symbol built from short source symbols is sent with its whole
+ * size but is zero past the longest of them: this finds where its content
+ * ends (reading the zeros once, rather than adding them to every partial
+ * sum of its equations).
+ */
+	static unsigned int
+TrimmedLength (
+		void*	symbol,
+		unsigned int	length)
+{
+	UINT8	*data = (UINT8*)symbol;
+	UINT64	word;
+
+	while (length >= sizeof(word)) {
+		memcpy(&word, data + length - sizeof(word), sizeof(word));
+		if (word != 0)
+			break;
+		length -= sizeof(word);
+	}
+	while (length > 0 && data[length - 1] == 0)
+		length--;
+	return length;
+}
+
+
 /******************************************************************************
  * DecodingStepWithSymbol: Perform a new decoding step with a new (given) symbol.
  * This is the legacy front end to the DecodingStepWithSymbol() method. The actual
@@ -16,21 +57,22 @@ DecodingWithSymbol (
 		void*	symbol_canvas[],
 		void*	new_symbol,
 		int	new_symbol_seqno,
+		unsigned int	new_symbol_length,
 		bool	store_symbol)
 {
 	void	*new_symbol_dst;	// temp variable used to store symbol
-	LDPC_head data_head;
 
 	// Fast path. If store symbol is not set, then call directly
 	// the full DecodingStepWithSymbol() method to avoid duplicate processing.
 
 	if (store_symbol == false) {
-		return(DecodingStepWithSymbol(Session, symbol_canvas, new_symbol, new_symbol_seqno)); 
+		return(DecodingStepWithSymbol(Session, symbol_canvas, new_symbol, new_symbol_seqno, new_symbol_length)); 
+	}
+	if (new_symbol_length > Session->m_symbolSize) {
+		return LDPC_ERROR;
 	}
 	// Step 0: check if this is a fresh symbol, otherwise return
-	if ((mod2sparse_last_in_col(Session->m_pchkMatrix, GetMatrixCol(Session, new_symbol_seqno))->row < 0)
-			|| (IsSourceSymbol(Session, new_symbol_seqno) && (symbol_canvas[new_symbol_seqno] != NULL))
-			|| (IsParitySymbol(Session, new_symbol_seqno) && (Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] != NULL))) {
+	if (IsAlreadyProcessed(Session, new_symbol_seqno)) {
 		// Symbol has already been processed, so skip it
 		return LDPC_OK;
 	}
@@ -44,32 +86,42 @@ DecodingWithSymbol (
 		// This is typically something which is done when this
 		// function is called recursively, for newly decoded
 		// symbols.
-		new_symbol_dst = (void *)malloc(Session->m_symbolSize);
+		new_symbol_dst = AllocDecodedSymbol(Session, new_symbol_seqno);
 		if (new_symbol_dst == NULL) {
 			return LDPC_ERROR;
 		}
 		// Copy data now
-		memcpy(GetBufferPtrOnly(new_symbol_dst), GetBuffer(new_symbol), Session->m_symbolSize);
+		memcpy(GetBufferPtrOnly(Session, new_symbol_dst), GetBuffer(Session, new_symbol), new_symbol_length);
+		StoreBuffer(Session, new_symbol_dst);
+		Session->m_ownedSourceSymbols[new_symbol_seqno] = new_symbol_dst;
 	} else {
 		new_symbol_dst = new_symbol;
 	}
 	/* continue decoding with the full DecodingStepWithSymbol() method */
-	return(DecodingStepWithSymbol(Session, symbol_canvas, new_symbol_dst, new_symbol_seqno)); 
+	return(DecodingStepWithSymbol(Session, symbol_canvas, new_symbol_dst, new_symbol_seqno, new_symbol_length)); 
 }
 
 
 /******************************************************************************
- * DecodingStepWithSymbol: Perform a new decoding step with a new (given) symbol.
- * => See header file for more informations.
+ * InjectSymbol: Steps 0 to 2 of DecodingStepWithSymbol, for a symbol that
+ * has just been received or decoded. Equations that reach degree 1 are
+ * pushed on the session's m_checkOfDeg1 queue, step 3 is left to the caller.
+ * new_symbol_length is the length of the symbol (see AddToSymbolLength):
+ * partial sums only grow up to the longest symbol added, so that short
+ * symbols cost no work on their zero padding.
+ * If owned is true, new_symbol is a buffer of the session's pool given to
+ * the decoder: a parity symbol worth keeping is then stored as is instead
+ * of being copied, and the caller frees new_symbol unless it ends up in
+ * m_parity_symbol_canvas.
  *
- * This function relies on the following simple algorithm:
+ * The decoder relies on the following simple algorithm:
  *
  * Given a set of linear equations, if one of them has only one
  * remaining unknown variable, then the value of this variable is
  * that of the constant term.
  * Replace this variable by its value in all remaining linear
  * equations, and reiterate. The value of several variables can
- * therefore be found by this recursive algorithm.
+ * therefore be found by this iterative algorithm.
  *
  * In practice, an incoming symbol contains the value of the associated
  * variable, so replace its value in all linear equations in which
@@ -83,38 +135,36 @@ DecodingWithSymbol (
  * equations, he then finds f1, he replaces its value in the first equation
  * and finds s1.
  */
-ldpc_error_status
-DecodingStepWithSymbol(
+	static ldpc_error_status
+InjectSymbol(
 		LDPCFecSession *Session,
 		void*	symbol_canvas[],
 		void*	new_symbol,
-		int	new_symbol_seqno)
+		int	new_symbol_seqno,
+		unsigned int	new_symbol_length,
+		bool	owned)
 {
 	mod2entry	*e = NULL;	// entry ("1") in parity check matrix
 	mod2entry	*delMe;		// temp: entry to delete in row/column
 	void		*currChk;	// temp: pointer to Partial sum
 	int		row;		// temp: current row value
-	int		*CheckOfDeg1 = NULL; // table of check nodes of degree
-	// one after the processing of new_symbol
-	int		CheckOfDeg1_nb = 0; // number of entries in table
-	int		CheckOfDeg1_listSize = 0; // size of the memory block
-	LDPC_head data_head;
-	// allocated for the table
+	void		*new_symbol_buf; // buffer of new_symbol
 	bool		keep_symbol;	// true if it's worth to store new_symbol
 	// in this function, in case it's a parity
 	// symbol, and independantly from the
 	// store_symbol argument.
 
 	// Step 0: check if this is a fresh symbol, otherwise return
-	if ((mod2sparse_last_in_col(Session->m_pchkMatrix, GetMatrixCol(Session, new_symbol_seqno))->row < 0)
-			|| (IsSourceSymbol(Session, new_symbol_seqno) && (symbol_canvas[new_symbol_seqno] != NULL))
-			|| (IsParitySymbol(Session, new_symbol_seqno) && (Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] != NULL))) {
+	if (IsAlreadyProcessed(Session, new_symbol_seqno)) {
 		// Symbol has already been processed, so skip it
 		return LDPC_OK;
 	}
 	// First, make sure data is available for this new symbol. Must
 	// remain valid throughout this function...
-	GetBuffer(new_symbol);
+	new_symbol_buf = GetBuffer(Session, new_symbol);
+
+	MarkSymbolKnown(Session, new_symbol_seqno);
+	Session->m_symbolLengths[new_symbol_seqno] = new_symbol_length;
 
 	// Step 1: Store the symbol in a permanent array. It concerns only DATA
 	// symbols. Parity symbols are only stored in permanent array, if we have
@@ -124,6 +174,7 @@ DecodingStepWithSymbol(
 		// There's no need to allocate anything, nor to call
 		// anything. It has already been done by the caller...
 		symbol_canvas[new_symbol_seqno] = new_symbol;
+		SourceSymbolAvailable(Session, symbol_canvas, new_symbol_seqno);
 		if (IsDecodingComplete(Session, symbol_canvas)) {
 			// Decoding is now finished, return...
 			return LDPC_OK;
@@ -163,13 +214,25 @@ DecodingStepWithSymbol(
 			// now take a decision...
 			if (PS_to_create > max_allowed_PS) {
 				// Parity symbol will be stored in a permanent array
-				// Alloc the buffer...
 				keep_symbol = true;
-				Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] =
-					(void *)malloc(Session->m_symbolSize);
-				// copy the content...
-				memcpy(GetBufferPtrOnly(Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols]),
-						GetBufferPtrOnly(new_symbol), Session->m_symbolSize);
+				if (owned) {
+					// The buffer is ours already, keep it
+					// as is.
+					Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] =
+						new_symbol;
+					StoreBuffer(Session, new_symbol);
+				} else {
+					// Alloc the buffer...
+					Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] =
+						AllocSymbol(Session);
+					if (Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] == NULL) {
+						goto no_mem;
+					}
+					// copy the content...
+					memcpy(GetBufferPtrOnly(Session, Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols]),
+							new_symbol_buf, new_symbol_length);
+					StoreBuffer(Session, Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols]);
+				}
 			} else {
 				// Parity symbol will only be added to partial sums
 				keep_symbol = false;
@@ -196,24 +259,22 @@ DecodingStepWithSymbol(
 			// last missing symbol of this equation, or because
 			// or some particular situation where it is non sense
 			// no to allocate a PS (m_triangleWithSmallFECRatio).
-			{
-				currChk = (void*) calloc(Session->m_symbolSize, 1);
-				memset(currChk, 0, Session->m_symbolSize);
-			}
-			if ((Session->m_checkValues[row] = currChk) == NULL) {
+			if ((currChk = AllocSymbol(Session)) == NULL) {
 				goto no_mem;
 			}
+			// not cleared: it is written as symbols are
+			// added
+			Session->m_checkValues[row] = currChk;
+			Session->m_checkLengths[row] = 0;
 		}
 		if (currChk != NULL) {
 			// there's a partial sum for this row...
 			if (Session->m_nbSymbols_in_equ[row] > 1) {
-				// Security: make sure data is available by
-				// calling GetBuffer(new_symbol) rather than
-				// GetBufferPtrOnly(new_symbol).
 				// we can add the symbol content to this PS
-				//printf("3': after add to currChk, fromdatabuf=x%x\n", GetBufferPtrOnly(new_symbol));
-				AddToSymbol(GetBufferPtrOnly(currChk),
-						GetBuffer(new_symbol));
+				//printf("3': after add to currChk, fromdatabuf=x%x\n", new_symbol_buf);
+				AddToSymbolLength(GetBuffer(Session, currChk),
+						&Session->m_checkLengths[row],
+						new_symbol_buf, new_symbol_length);
 				//printf("3: before add to currChk, to databuf=x%x\n", GetBufferPtrOnly(currChk));
 			}
 			// else this is useless, since new_symbol is the last
@@ -260,9 +321,11 @@ DecodingStepWithSymbol(
 					if (tmp_symbol != NULL) {
 						// add the symbol content now
 						//printf("4: ready to add to currChk the tmp_symbol seq=%d, fromdatabuf=x%x\n", tmp_seqno, GetBufferPtrOnly(tmp_symbol));
-						AddToSymbol(
-								GetBufferPtrOnly(currChk),
-								GetBuffer(tmp_symbol));
+						AddToSymbolLength(
+								GetBuffer(Session, currChk),
+								&Session->m_checkLengths[row],
+								GetBuffer(Session, tmp_symbol),
+								Session->m_symbolLengths[tmp_seqno]);
 						//printf("5: add to currChk done, todatabuf=x%x\n", GetBufferPtrOnly(currChk));
 						// delete the entry
 						delMe = tmp_e;
@@ -274,7 +337,7 @@ DecodingStepWithSymbol(
 							// check if we can delete
 							// parity symbol altogether
 							if (Session->m_nbEqu_for_parity[tmp_seqno - Session->m_nbSourceSymbols] == 0) {
-								free(tmp_symbol);
+								FreeSymbol(Session, tmp_symbol);
 								Session->m_parity_symbol_canvas[tmp_seqno - Session->m_nbSourceSymbols] = NULL;
 							}
 						}
@@ -293,42 +356,84 @@ DecodingStepWithSymbol(
 		if (Session->m_nbSymbols_in_equ[row] == 1) {
 			// register this entry for step 3 since the symbol
 			// associated to this equation can now be decoded...
-			if (CheckOfDeg1 == NULL) {
-				// allocate memory for the table first
-				CheckOfDeg1_listSize = 4;
-				if ((CheckOfDeg1 = (int*)
-							calloc(CheckOfDeg1_listSize,
-								sizeof(int*))) == NULL) {
-					goto no_mem;
-				}
-			} else if (CheckOfDeg1_nb == CheckOfDeg1_listSize) {
-				// not enough size in table, add some more
-				CheckOfDeg1_listSize += 4;
-				if ((CheckOfDeg1 = (int*)realloc(CheckOfDeg1,
-								CheckOfDeg1_listSize * sizeof(int*))) == NULL) {
-					goto no_mem;
-				}
+			// A row reaches degree 1 only once, so the queue
+			// (one entry per row) cannot overflow.
+			if (Session->m_checkOfDeg1_nb == Session->m_nbParitySymbols) {
+				return LDPC_ERROR;
 			}
-			CheckOfDeg1[CheckOfDeg1_nb++] = row;
+			Session->m_checkOfDeg1[Session->m_checkOfDeg1_nb++] = row;
 		}
 	}
+	return LDPC_OK;
+
+no_mem:
+	return LDPC_ERROR;
+}
+
+
+/******************************************************************************
+ * DecodingStep: Body of DecodingStepWithSymbol and DecodingWithOwnedSymbol,
+ * owned being true for a parity symbol given to the decoder (see
+ * InjectSymbol), which frees it once it is no longer needed.
+ *
+ * Step 3 below: each equation of degree 1 gives a new symbol, which is in
+ * turn injected in all its equations (InjectSymbol), which may create new
+ * equations of degree 1, and so on.
+ * Instead of calling this function recursively for each decoded symbol,
+ * equations of degree 1 are pushed on a worklist owned by the session
+ * (m_checkOfDeg1) and popped in LIFO order. This processes equations in
+ * exactly the same order as a recursive implementation would, hence the
+ * same results, with a constant stack depth and no allocation.
+ */
+	static ldpc_error_status
+DecodingStep(
+		LDPCFecSession *Session,
+		void*	symbol_canvas[],
+		void*	new_symbol,
+		int	new_symbol_seqno,
+		unsigned int	new_symbol_length,
+		bool	owned)
+{
+	mod2entry	*e;		// entry ("1") in parity check matrix
+	void		*currChk;	// temp: pointer to Partial sum
+	int		row;		// temp: current row value
+	int		decoded_symbol_seqno;	// sequence number of decoded symbol
+	unsigned int	length;		// length of a symbol
+
+	Session->m_nbReceived++;
+
+	// Steps 0 to 2 for the new symbol. The queue is empty here.
+	Session->m_checkOfDeg1_nb = 0;
+	length = new_symbol_length;
+	if (IsParitySymbol(Session, new_symbol_seqno)) {
+		length = TrimmedLength(GetBuffer(Session, new_symbol), length);
+	}
+	if (InjectSymbol(Session, symbol_canvas, new_symbol, new_symbol_seqno,
+				length, owned) != LDPC_OK) {
+		if (owned && Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] != new_symbol) {
+			FreeSymbol(Session, new_symbol);
+		}
+		goto error;
+	}
+	if (owned && Session->m_parity_symbol_canvas[new_symbol_seqno - Session->m_nbSourceSymbols] != new_symbol) {
+		// only added to partial sums
+		FreeSymbol(Session, new_symbol);
+	}
 
 	// Step 3: Check if a new symbol has been decoded and take appropriate
 	// measures ...
-	int	decoded_symbol_seqno;	// sequence number of decoded symbol
-	//for (int i = 0; i < CheckOfDeg1_nb; i++) 
-	for (CheckOfDeg1_nb--; CheckOfDeg1_nb >= 0; CheckOfDeg1_nb--) {
+	while (Session->m_checkOfDeg1_nb > 0) {
 		if (IsDecodingComplete(Session, symbol_canvas)) {
 			// decoding has just finished, no need to do anything else
 			break;
 		}
 		// get the index (ie row) of the partial sum concerned
-		row = CheckOfDeg1[CheckOfDeg1_nb];
+		row = Session->m_checkOfDeg1[--Session->m_checkOfDeg1_nb];
 		if (Session->m_nbSymbols_in_equ[row] == 1) {
 			// A new decoded symbol is available...
-			// NB: because of the recursion below, we need to
-			// check that all equations mentioned in the
-			// CheckOfDeg1 list are __still__ of degree 1.
+			// NB: because of the symbols decoded in between, we
+			// need to check that all equations mentioned in the
+			// queue are __still__ of degree 1.
 			e = mod2sparse_first_in_row(Session->m_pchkMatrix, row);
 			decoded_symbol_seqno = GetSymbolSeqno(Session, e->col);
 			// remove the entry from the matrix
@@ -343,53 +448,125 @@ DecodingStepWithSymbol(
 				// source symbol.
 				void	*decoded_symbol_dst;// temp variable used to store symbol
 
-				// First copy it into a permanent symbol.
-				// Call any required callback, or allocate memory, and
-				// copy the symbol content in it.
-				decoded_symbol_dst =
-					(void *)malloc(Session->m_symbolSize);
-				if (decoded_symbol_dst == NULL) {
-					goto no_mem;
+				length = Session->m_checkLengths[row];
+				if (Session->m_memoryCallbacks.decodedSymbol != NULL) {
+					// The application tells where to store it:
+					// copy it there.
+					decoded_symbol_dst = AllocDecodedSymbol(Session, decoded_symbol_seqno);
+					if (decoded_symbol_dst == NULL) {
+						FreeSymbol(Session, currChk);
+						goto error;
+					}
+					memcpy(GetBufferPtrOnly(Session, decoded_symbol_dst),
+							GetBuffer(Session, currChk), length);
+					FreeSymbol(Session, currChk);
+				} else {
+					// The partial sum, a symbol of the session,
+					// becomes the decoded symbol: there is
+					// nothing to copy.
+					decoded_symbol_dst = currChk;
 				}
-				memcpy(GetBufferPtrOnly(decoded_symbol_dst),
-						GetBuffer(currChk), Session->m_symbolSize);
-				// Free partial sum which is no longer used.
-				// It's important to free it before calling
-				// DecodingStepWithSymbol recursively to reduce max
-				// memory requirements.
-				free(currChk);
-				//printf("get data buf seqno:%d\n", decoded_symbol_seqno);
-				memcpy(&data_head, decoded_symbol_dst, sizeof(data_head));
-				data_head.type_flag = 0;
-				data_head.longest_length = Session->m_symbolSize;
-				memcpy(decoded_symbol_dst, &data_head, sizeof(data_head));
-
-				// And finally call this method recursively
-				DecodingStepWithSymbol(Session, symbol_canvas, decoded_symbol_dst,
-						decoded_symbol_seqno);
+				StoreBuffer(Session, decoded_symbol_dst);
+				Session->m_ownedSourceSymbols[decoded_symbol_seqno] = decoded_symbol_dst;
 
-			} else {
-				//printf("get fec buf seqno:%d\n", decoded_symbol_seqno);
-				memcpy(&data_head, currChk, sizeof(data_head));
-				data_head.type_flag = 1;
-				data_head.longest_length = Session->m_symbolSize;
-				memcpy(currChk, &data_head, sizeof(data_head));
+				// And inject it, which may push new equations of
+				// degree 1
+				if (InjectSymbol(Session, symbol_canvas, decoded_symbol_dst,
+							decoded_symbol_seqno, length, false) != LDPC_OK) {
+					goto error;
+				}
 
+			} else {
 				// Parity symbol.
-				// Call this method recursively first...
-				DecodingStepWithSymbol(Session, symbol_canvas, currChk,
-						decoded_symbol_seqno);
-				// Then free the partial sum which is no longer needed.
-				free(currChk);	
+				// Inject it, the partial sum being kept as the
+				// parity symbol if needed...
+				if (InjectSymbol(Session, symbol_canvas, currChk,
+							decoded_symbol_seqno, Session->m_checkLengths[row],
+							true) != LDPC_OK) {
+					if (Session->m_parity_symbol_canvas[decoded_symbol_seqno - Session->m_nbSourceSymbols] != currChk) {
+						FreeSymbol(Session, currChk);
+					}
+					goto error;
+				}
+				// ...otherwise free it, it is no longer needed.
+				if (Session->m_parity_symbol_canvas[decoded_symbol_seqno - Session->m_nbSourceSymbols] != currChk) {
+					FreeSymbol(Session, currChk);
+				}
 			}
 		}
 	}
-	if (CheckOfDeg1 != NULL) {
-		free(CheckOfDeg1);
+	Session->m_checkOfDeg1_nb = 0;
+
+	// Step 4: the iterative decoder is stuck, but with at least k symbols
+	// there is a good chance that the remaining system has a unique
+	// solution. Failing here only means that more symbols are needed,
+	// at least as many as the system lacked equations last time.
+	if (Session->m_mlDecoding &&
+			Session->m_nbReceived >= Session->m_nbSourceSymbols &&
+			Session->m_nbReceived >= Session->m_mlRetryAt &&
+			!IsDecodingComplete(Session, symbol_canvas)) {
+		DecodingWithML(Session, symbol_canvas);
 	}
 	return LDPC_OK;
 
-no_mem:
+error:
+	Session->m_checkOfDeg1_nb = 0;
 	return LDPC_ERROR;
 }
 
+
+/******************************************************************************
+ * DecodingStepWithSymbol: Perform a new decoding step with a new (given) symbol.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+DecodingStepWithSymbol(
+		LDPCFecSession *Session,
+		void*	symbol_canvas[],
+		void*	new_symbol,
+		int	new_symbol_seqno,
+		unsigned int	new_symbol_length)
+{
+	if (IsAlreadyProcessed(Session, new_symbol_seqno)) {
+		// Symbol has already been processed, so skip it
+		return LDPC_OK;
+	}
+	if (new_symbol_length > Session->m_symbolSize) {
+		return LDPC_ERROR;
+	}
+	return DecodingStep(Session, symbol_canvas, new_symbol, new_symbol_seqno,
+			new_symbol_length, false);
+}
+
+
+/******************************************************************************
+ * DecodingWithOwnedSymbol: Perform a new decoding step with a new symbol
+ * given to the decoder.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+DecodingWithOwnedSymbol(
+		LDPCFecSession *Session,
+		void*	symbol_canvas[],
+		void*	new_symbol,
+		int	new_symbol_seqno,
+		unsigned int	new_symbol_length)
+{
+	if (new_symbol_length > Session->m_symbolSize) {
+		FreeSymbol(Session, new_symbol);
+		return LDPC_ERROR;
+	}
+	if (IsAlreadyProcessed(Session, new_symbol_seqno)) {
+		// Symbol has already been processed, so skip it
+		FreeSymbol(Session, new_symbol);
+		return LDPC_OK;
+	}
+	if (IsSourceSymbol(Session, new_symbol_seqno)) {
+		// stored in symbol_canvas as is, like a decoded symbol
+		Session->m_ownedSourceSymbols[new_symbol_seqno] = new_symbol;
+		return DecodingStep(Session, symbol_canvas, new_symbol, new_symbol_seqno,
+				new_symbol_length, false);
+	}
+	return DecodingStep(Session, symbol_canvas, new_symbol, new_symbol_seqno,
+			new_symbol_length, true);
+}
@@ -0,0 +1,736 @@
+#include "ldpc_fec.h"
+
+/******************************************************************************/
+/*
+ * Decoder using Maximum Likelihood decoding, i.e. Gaussian elimination on the
+ * equations the iterative decoder could not solve.
+ *
+ * The remaining system (unknown symbols = variables, rows of the working
+ * matrix that still contain at least one of them = equations) is solved in
+ * three phases:
+ *
+ * 1- Structured elimination, on the matrix only. An equation with a single
+ *    active variable solves it (the variable is "pivoted" by the equation),
+ *    exactly as in iterative decoding. When no such equation remains, the
+ *    active variable that appears in the most equations among those of an
+ *    equation of minimum degree is "inactivated", i.e. treated as a known
+ *    constant for now, and the process goes on. This keeps the sparse part
+ *    sparse: every pivoted variable is expressed as a sum of symbols plus a
+ *    combination of inactivated variables (a bit-packed row, pivotBits).
+ * 2- The equations that pivoted nothing are rewritten over the inactivated
+ *    variables only, which gives a small dense GF(2) system, solved by
+ *    Gaussian elimination on bit-packed rows. If it does not have full rank,
+ *    decoding stops here and no symbol has been touched.
+ * 3- The same operations are done on the symbols: right hand sides of the
+ *    pivot equations, dense elimination and back-substitution give the
+ *    inactivated variables, from which the pivoted source symbols follow.
+ */
+
+/* Status of a variable. */
+#define VAR_ACTIVE	0	/* not solved yet */
+#define VAR_PIVOT	1	/* solved by a pivot equation */
+#define VAR_INACTIVE	2	/* solved in the dense system */
+
+typedef struct {
+	int	nbVars;		// number of variables (unknown symbols)
+	int*	varCol;		// Array: matrix column of each variable
+	int*	colVar;		// Array: variable of each column, -1 if none
+	char*	varStatus;	// Array: VAR_ACTIVE, VAR_PIVOT or VAR_INACTIVE
+	int*	varIndex;	// Array: pivot equation (VAR_PIVOT), or column in
+	// the dense system (VAR_INACTIVE)
+
+	int	nbEqus;		// number of equations
+	int*	equRow;		// Array: matrix row of each equation
+	// The system itself, in compact form: walking the linked lists of
+	// the working matrix at each step would cost a cache miss per entry.
+	int*	equPtr;		// Array: nbEqus+1 offsets in equVars
+	int*	equVars;	// Array: variables of each equation
+	int*	varPtr;		// Array: nbVars+1 offsets in varEqus
+	int*	varEqus;	// Array: equations of each variable
+	int*	activeDeg;	// Array: nb of active variables per equation
+	int*	equPivot;	// Array: variable pivoted by each equation, or -1
+	int*	pivotOrder;	// Array: pivot equations, in pivot order
+	int*	pivotWords;	// Array: words used in the pivotBits row of
+	// each pivot equation, which only depends on the variables
+	// inactivated before its pivot
+	int	nbPivots;
+	int*	bucketHead;	// Array: first non pivot equation of each active
+	// degree (>= 2), or -1. Degrees only decrease during elimination,
+	// so that the equations of minimum degree are found without
+	// scanning all of them.
+	int*	bucketNext;	// Array: next/previous equation of the same
+	int*	bucketPrev;	// degree, -1 at the ends
+	int	minDeg;		// no equation has a lower degree (>= 2)
+
+	int	nbInactive;	// number of inactivated variables
+	int	words;		// UINT64 words per bit-packed row
+	UINT64*	pivotBits;	// nbEqus rows: inactivated variables each
+	// pivoted variable depends on
+	int*	denseEqu;	// Array: equations of the dense system
+	int	nbDense;
+	UINT64*	denseBits;	// nbDense rows: the dense system
+	int*	densePivot;	// Array: dense row solving each inactivated variable
+	char*	isDensePivot;	// Array: true for dense rows that are pivots
+
+	void**	rhs;		// Array: right hand side symbol of each equation
+	UINT8**	rhsData;	// Array: buffer of each right hand side
+	unsigned int	symbolSize; // length of the right hand sides
+
+	int	deficit;	// if there is no unique solution: nbVars minus
+	// the rank of the system (or a lower bound of it), i.e. the
+	// minimum number of new symbols before a solution may exist
+} ml_system;
+
+#define BIT_GET(r,i)	(((r)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BIT_FLIP(r,i)	((r)[(i) >> 6] ^= ((UINT64)1 << ((i) & 63)))
+
+
+	static void
+FreeSystem (
+		LDPCFecSession *Session,
+		ml_system *sys)
+{
+	int	i;
+
+	if (sys->rhs != NULL) {
+		for (i = 0; i < sys->nbEqus; i++) {
+			FreeSymbol(Session, sys->rhs[i]);
+		}
+		free(sys->rhs);
+	}
+	free(sys->rhsData);
+	free(sys->varCol);
+	free(sys->colVar);
+	free(sys->varStatus);
+	free(sys->varIndex);
+	free(sys->equRow);
+	free(sys->equPtr);
+	free(sys->equVars);
+	free(sys->varPtr);
+	free(sys->varEqus);
+	free(sys->activeDeg);
+	free(sys->equPivot);
+	free(sys->pivotOrder);
+	free(sys->pivotWords);
+	free(sys->bucketHead);
+	free(sys->bucketNext);
+	free(sys->bucketPrev);
+	free(sys->pivotBits);
+	free(sys->denseEqu);
+	free(sys->denseBits);
+	free(sys->densePivot);
+	free(sys->isDensePivot);
+}
+
+
+/*
+ * Returns the symbol associated to a matrix column if it is known
+ * (received or decoded, and still available), NULL otherwise.
+ */
+	static void*
+KnownSymbol (
+		LDPCFecSession *Session,
+		void*	symbol_canvas[],
+		int	col)
+{
+	int	seqno = GetSymbolSeqno(Session, col);
+
+	if (IsSourceSymbol(Session, seqno)) {
+		return symbol_canvas[seqno];
+	} else {
+		return Session->m_parity_symbol_canvas[seqno - Session->m_nbSourceSymbols];
+	}
+}
+
+
+/*
+ * Phase 0: list the variables and equations of the remaining system, i.e.
+ * the rows of the working matrix with at least one unknown symbol.
+ * The working matrix only loses the entries of known symbols, so the
+ * entries of the unknown ones are read from the shared compressed matrix.
+ */
+	static ldpc_error_status
+BuildSystem (
+		LDPCFecSession *Session,
+		ml_system *sys)
+{
+	mod2csr		*m = Session->m_pchkCompressed;
+	int		nbCols = mod2csr_cols(m);
+	int		nbRows = mod2csr_rows(m);
+	int		nbEntries = 0;
+	int		nbSourceVars = 0;
+	int		col, row, var, equ, i, first, seqno;
+
+	// rows solved by the iterative decoder have no entry left, but
+	// still count their last symbol as unknown.
+	for (row = 0; row < nbRows; row++) {
+		if (Session->m_nbSymbols_in_equ[row] > 0 && Session->m_nb_unknown_symbols[row] > 0)
+			nbEntries += Session->m_nb_unknown_symbols[row];
+	}
+	if (((sys->colVar = (int*)malloc(nbCols * sizeof(int))) == NULL) ||
+			((sys->varCol = (int*)malloc(nbCols * sizeof(int))) == NULL) ||
+			((sys->equRow = (int*)malloc(nbRows * sizeof(int))) == NULL) ||
+			((sys->equPtr = (int*)malloc((nbRows + 1) * sizeof(int))) == NULL) ||
+			((sys->equVars = (int*)malloc((nbEntries + 1) * sizeof(int))) == NULL)) {
+		return LDPC_ERROR;
+	}
+	for (col = 0; col < nbCols; col++)
+		sys->colVar[col] = -1;
+	sys->nbVars = 0;
+	sys->nbEqus = 0;
+	sys->equPtr[0] = 0;
+	nbEntries = 0;
+	for (row = 0; row < nbRows; row++) {
+		if (Session->m_nbSymbols_in_equ[row] == 0 || Session->m_nb_unknown_symbols[row] <= 0)
+			continue;
+		first = nbEntries;
+		for (i = mod2csr_row_begin(m, row); i < mod2csr_row_end(m, row); i++) {
+			col = mod2csr_col(m, i);
+			if (sys->colVar[col] == -1) {
+				// first time this column is met
+				seqno = GetSymbolSeqno(Session, col);
+				if (IsSymbolKnown(Session, seqno)) {
+					sys->colVar[col] = -2;
+					continue;
+				}
+				if (IsSourceSymbol(Session, seqno))
+					nbSourceVars++;
+				sys->colVar[col] = sys->nbVars;
+				sys->varCol[sys->nbVars++] = col;
+			} else if (sys->colVar[col] < 0) {
+				continue;
+			}
+			if (nbEntries == first + Session->m_nb_unknown_symbols[row]) {
+				// cannot happen: m_nb_unknown_symbols counts them
+				return LDPC_ERROR;
+			}
+			sys->equVars[nbEntries++] = sys->colVar[col];
+		}
+		if (nbEntries > first) {
+			sys->equRow[sys->nbEqus++] = row;
+			sys->equPtr[sys->nbEqus] = nbEntries;
+		}
+	}
+	if (nbSourceVars < Session->m_nbMissingSources) {
+		// unknown source symbols involved in no equation: they can
+		// only be received.
+		sys->deficit = Session->m_nbMissingSources - nbSourceVars;
+		return LDPC_ERROR;
+	}
+	if (sys->nbEqus < sys->nbVars) {
+		// not enough equations, no need to go further
+		sys->deficit = sys->nbVars - sys->nbEqus;
+		return LDPC_ERROR;
+	}
+
+	// equations of each variable, by counting sort
+	if (((sys->varPtr = (int*)calloc(sys->nbVars + 1, sizeof(int))) == NULL) ||
+			((sys->varEqus = (int*)malloc((nbEntries + 1) * sizeof(int))) == NULL) ||
+			((sys->varStatus = (char*)calloc(sys->nbVars, sizeof(char))) == NULL) ||
+			((sys->varIndex = (int*)calloc(sys->nbVars, sizeof(int))) == NULL) ||
+			((sys->activeDeg = (int*)malloc(sys->nbEqus * sizeof(int))) == NULL) ||
+			((sys->equPivot = (int*)malloc(sys->nbEqus * sizeof(int))) == NULL) ||
+			((sys->pivotOrder = (int*)malloc(sys->nbEqus * sizeof(int))) == NULL) ||
+			((sys->pivotWords = (int*)malloc(sys->nbEqus * sizeof(int))) == NULL)) {
+		return LDPC_ERROR;
+	}
+	for (i = 0; i < nbEntries; i++)
+		sys->varPtr[sys->equVars[i] + 1]++;
+	for (var = 0; var < sys->nbVars; var++)
+		sys->varPtr[var + 1] += sys->varPtr[var];
+	for (equ = 0; equ < sys->nbEqus; equ++) {
+		for (i = sys->equPtr[equ]; i < sys->equPtr[equ + 1]; i++)
+			sys->varEqus[sys->varPtr[sys->equVars[i]]++] = equ;
+	}
+	for (var = sys->nbVars; var > 0; var--)
+		sys->varPtr[var] = sys->varPtr[var - 1];
+	sys->varPtr[0] = 0;
+	for (equ = 0; equ < sys->nbEqus; equ++) {
+		sys->equPivot[equ] = -1;
+		sys->activeDeg[equ] = sys->equPtr[equ + 1] - sys->equPtr[equ];
+	}
+	return LDPC_OK;
+}
+
+
+/*
+ * Degree buckets: adds or removes an equation of degree >= 2.
+ */
+	static void
+BucketInsert (
+		ml_system *sys,
+		int	equ)
+{
+	int	deg = sys->activeDeg[equ];
+
+	sys->bucketPrev[equ] = -1;
+	sys->bucketNext[equ] = sys->bucketHead[deg];
+	if (sys->bucketHead[deg] >= 0)
+		sys->bucketPrev[sys->bucketHead[deg]] = equ;
+	sys->bucketHead[deg] = equ;
+	if (deg < sys->minDeg)
+		sys->minDeg = deg;
+}
+
+	static void
+BucketRemove (
+		ml_system *sys,
+		int	equ)
+{
+	if (sys->bucketPrev[equ] >= 0)
+		sys->bucketNext[sys->bucketPrev[equ]] = sys->bucketNext[equ];
+	else
+		sys->bucketHead[sys->activeDeg[equ]] = sys->bucketNext[equ];
+	if (sys->bucketNext[equ] >= 0)
+		sys->bucketPrev[sys->bucketNext[equ]] = sys->bucketPrev[equ];
+}
+
+
+/*
+ * One active variable less in an equation, which moves to the bucket below
+ * (if it is not a pivot equation). Returns its new degree.
+ */
+	static int
+DecreaseDegree (
+		ml_system *sys,
+		int	equ)
+{
+	bool	bucketed = (sys->equPivot[equ] < 0 && sys->activeDeg[equ] >= 2);
+
+	if (bucketed)
+		BucketRemove(sys, equ);
+	if (--sys->activeDeg[equ] >= 2 && bucketed)
+		BucketInsert(sys, equ);
+	return sys->activeDeg[equ];
+}
+
+
+/*
+ * Phase 1: structured elimination with inactivation (matrix only).
+ */
+	static ldpc_error_status
+Eliminate (
+		ml_system *sys)
+{
+	int		*stack;		// equations with one active variable
+	int		stack_nb = 0;
+	int		nbActive = sys->nbVars;
+	int		equ, var, f, i, j, best, bestDeg, deg;
+
+	if (((stack = (int*)malloc(sys->nbEqus * sizeof(int))) == NULL) ||
+			((sys->bucketHead = (int*)malloc((sys->nbVars + 1) * sizeof(int))) == NULL) ||
+			((sys->bucketNext = (int*)malloc(sys->nbEqus * sizeof(int))) == NULL) ||
+			((sys->bucketPrev = (int*)malloc(sys->nbEqus * sizeof(int))) == NULL)) {
+		free(stack);
+		return LDPC_ERROR;
+	}
+	for (deg = 0; deg <= sys->nbVars; deg++)
+		sys->bucketHead[deg] = -1;
+	sys->minDeg = sys->nbVars + 1;
+	for (equ = 0; equ < sys->nbEqus; equ++) {
+		if (sys->activeDeg[equ] == 1)
+			stack[stack_nb++] = equ;
+		else if (sys->activeDeg[equ] >= 2)
+			BucketInsert(sys, equ);
+	}
+	sys->nbPivots = 0;
+	sys->nbInactive = 0;
+	while (nbActive > 0) {
+		while (stack_nb > 0) {
+			equ = stack[--stack_nb];
+			if (sys->equPivot[equ] >= 0 || sys->activeDeg[equ] != 1)
+				continue;
+			// find its only active variable: it is solved by equ
+			var = -1;
+			for (i = sys->equPtr[equ]; i < sys->equPtr[equ + 1]; i++) {
+				if (sys->varStatus[sys->equVars[i]] == VAR_ACTIVE) {
+					var = sys->equVars[i];
+					break;
+				}
+			}
+			if (var < 0) {
+				// cannot happen: activeDeg counts the active
+				// variables of the equation.
+				free(stack);
+				return LDPC_ERROR;
+			}
+			sys->varStatus[var] = VAR_PIVOT;
+			sys->varIndex[var] = equ;
+			sys->equPivot[equ] = var;
+			sys->pivotWords[equ] = (sys->nbInactive + 63) / 64;
+			sys->pivotOrder[sys->nbPivots++] = equ;
+			nbActive--;
+			for (j = sys->varPtr[var]; j < sys->varPtr[var + 1]; j++) {
+				f = sys->varEqus[j];
+				// each equation enters the stack at most once
+				if (DecreaseDegree(sys, f) == 1 && sys->equPivot[f] < 0)
+					stack[stack_nb++] = f;
+			}
+		}
+		if (nbActive == 0)
+			break;
+		// Stuck: take an equation of minimum degree, and inactivate
+		// its variable that appears in the most equations.
+		while (sys->minDeg <= sys->nbVars && sys->bucketHead[sys->minDeg] < 0)
+			sys->minDeg++;
+		best = (sys->minDeg <= sys->nbVars) ? sys->bucketHead[sys->minDeg] : -1;
+		if (best < 0) {
+			// cannot happen: an active variable always
+			// belongs to a non pivot equation.
+			free(stack);
+			return LDPC_ERROR;
+		}
+		var = -1;
+		bestDeg = -1;
+		for (i = sys->equPtr[best]; i < sys->equPtr[best + 1]; i++) {
+			f = sys->equVars[i];
+			if (sys->varStatus[f] != VAR_ACTIVE)
+				continue;
+			deg = sys->varPtr[f + 1] - sys->varPtr[f];
+			if (deg > bestDeg) {
+				bestDeg = deg;
+				var = f;
+			}
+		}
+		sys->varStatus[var] = VAR_INACTIVE;
+		sys->varIndex[var] = sys->nbInactive++;
+		nbActive--;
+		for (j = sys->varPtr[var]; j < sys->varPtr[var + 1]; j++) {
+			f = sys->varEqus[j];
+			if (DecreaseDegree(sys, f) == 1 && sys->equPivot[f] < 0)
+				stack[stack_nb++] = f;
+		}
+	}
+	free(stack);
+	return LDPC_OK;
+}
+
+
+/*
+ * Bit-packed row of an equation over the inactivated variables, once all
+ * its pivoted variables have been substituted (their own rows must already
+ * be known).
+ */
+	static void
+SubstituteBits (
+		ml_system *sys,
+		int	equ,
+		UINT64	*bits)
+{
+	UINT64		*src;
+	int		i, var, w, words;
+
+	memset(bits, 0, sys->words * sizeof(UINT64));
+	for (i = sys->equPtr[equ]; i < sys->equPtr[equ + 1]; i++) {
+		var = sys->equVars[i];
+		if (var == sys->equPivot[equ])
+			continue;
+		if (sys->varStatus[var] == VAR_INACTIVE) {
+			BIT_FLIP(bits, sys->varIndex[var]);
+		} else {
+			src = sys->pivotBits + (size_t)sys->varIndex[var] * sys->words;
+			words = sys->pivotWords[sys->varIndex[var]];
+			for (w = 0; w < words; w++)
+				bits[w] ^= src[w];
+		}
+	}
+}
+
+
+/*
+ * Forward Gaussian elimination of the dense system. Rows are XORed in
+ * place, and if with_symbols is true the same operation is done on the
+ * right hand sides of the rows that end up as pivots (the others are
+ * never used). Running it twice on the same rows makes the same choices.
+ * Returns the number of inactivated variables left without a pivot, i.e.
+ * 0 if the system has full rank, or -1 if out of memory.
+ */
+	static int
+DenseElimination (
+		ml_system *sys,
+		UINT64	*rows,
+		bool	with_symbols)
+{
+	int	*order = NULL;	// dense rows, pivots first
+	int	nb = 0;		// pivots found so far
+	int	c, r, p, q, tmp;
+	UINT64	*pr, *qr, *src, *dst, *end;
+
+	if ((order = (int*)malloc((sys->nbDense + 1) * sizeof(int))) == NULL)
+		return -1;
+	for (r = 0; r < sys->nbDense; r++)
+		order[r] = r;
+	for (c = 0; c < sys->nbInactive; c++) {
+		for (r = nb; r < sys->nbDense; r++) {
+			if (BIT_GET(rows + (size_t)order[r] * sys->words, c))
+				break;
+		}
+		if (r == sys->nbDense) {
+			// no pivot: go on all the same, to get the rank
+			continue;
+		}
+		tmp = order[nb];
+		order[nb] = order[r];
+		order[r] = tmp;
+		p = order[nb++];
+		pr = rows + (size_t)p * sys->words;
+		sys->densePivot[c] = p;
+		for (r = nb; r < sys->nbDense; r++) {
+			q = order[r];
+			qr = rows + (size_t)q * sys->words;
+			if (!BIT_GET(qr, c))
+				continue;
+			// words before c >> 6 are null in both rows
+			end = qr + sys->words;
+			for (dst = qr + (c >> 6), src = pr + (c >> 6); dst < end; )
+				*dst++ ^= *src++;
+			if (with_symbols && sys->isDensePivot[q]) {
+				AddToSymbol(sys->rhsData[sys->denseEqu[q]], sys->rhsData[sys->denseEqu[p]],
+						sys->symbolSize);
+			}
+		}
+	}
+	free(order);
+	return sys->nbInactive - nb;
+}
+
+
+/*
+ * Allocates the right hand side of an equation: its partial sum if any,
+ * plus all the known symbols still in the equation (the working matrix is
+ * only walked if there are any). Right hand sides are
+ * whole symbols (m_symbolSize bytes long), whose buffers are kept in
+ * rhsData.
+ */
+	static void*
+InitRhs (
+		LDPCFecSession *Session,
+		void*	symbol_canvas[],
+		ml_system *sys,
+		int	equ)
+{
+	mod2entry	*e;
+	void		*rhs, *known;
+	UINT8		*data;
+	int		row = sys->equRow[equ];
+	unsigned int	len = Session->m_symbolSize;
+	unsigned int	live = 0;
+
+	if ((rhs = AllocSymbol(Session)) == NULL)
+		return NULL;
+	data = sys->rhsData[equ] = (UINT8*)GetBufferPtrOnly(Session, rhs);
+	if (Session->m_checkValues[row] != NULL) {
+		live = Session->m_checkLengths[row];
+		memcpy(data, GetBuffer(Session, Session->m_checkValues[row]), live);
+	}
+	memset(data + live, 0, Session->m_symbolSize - live);
+	if (Session->m_nbSymbols_in_equ[row] == sys->equPtr[equ + 1] - sys->equPtr[equ]) {
+		// only variables are left in the equation
+		return rhs;
+	}
+	for (e = mod2sparse_first_in_row(Session->m_pchkMatrix, row); !mod2sparse_at_end(e);
+			e = mod2sparse_next_in_row(e)) {
+		if (sys->colVar[e->col] < 0 &&
+				(known = KnownSymbol(Session, symbol_canvas, e->col)) != NULL) {
+			AddToSymbolLength(data, &len, GetBuffer(Session, known),
+					Session->m_symbolLengths[GetSymbolSeqno(Session, e->col)]);
+		}
+	}
+	return rhs;
+}
+
+
+/*
+ * Adds to the right hand side of an equation the right hand sides of its
+ * pivoted variables (other than the one it pivots itself), and if
+ * inactive is true the values of its inactivated variables (once known).
+ */
+	static void
+SubstituteSymbols (
+		LDPCFecSession *Session,
+		ml_system *sys,
+		int	equ,
+		bool	inactive)
+{
+	int		i, var;
+
+	for (i = sys->equPtr[equ]; i < sys->equPtr[equ + 1]; i++) {
+		var = sys->equVars[i];
+		if (var == sys->equPivot[equ])
+			continue;
+		if (sys->varStatus[var] == VAR_PIVOT) {
+			AddToSymbol(sys->rhsData[equ], sys->rhsData[sys->varIndex[var]], Session->m_symbolSize);
+		} else if (inactive) {
+			AddToSymbol(sys->rhsData[equ],
+					sys->rhsData[sys->denseEqu[sys->densePivot[sys->varIndex[var]]]],
+					Session->m_symbolSize);
+		}
+	}
+}
+
+
+/******************************************************************************
+ * SetMLDecoding: Enables or disables automatic ML decoding.
+ * => See header file for more informations.
+ */
+	void
+SetMLDecoding (LDPCFecSession *Session, bool enable)
+{
+	Session->m_mlDecoding = enable;
+}
+
+
+/******************************************************************************
+ * DecodingWithML: Maximum likelihood decoding of the missing source symbols.
+ * => See header file for more informations.
+ */
+	ldpc_error_status
+DecodingWithML (
+		LDPCFecSession *Session,
+		void*	symbol_canvas[])
+{
+	ml_system	sys;
+	UINT64		*denseCopy = NULL;
+	UINT64		*bits;
+	void		*dst;
+	ldpc_error_status ret = LDPC_ERROR;
+	int		i, c, c2, equ, var, seqno, missing;
+
+	if (!Session->m_initialized || !(Session->m_sessionFlags & FLAG_DECODER)) {
+		fprintf(stderr, "LDPCFecSession::DecodingWithML: ERROR: not a decoding session!\n");
+		return LDPC_ERROR;
+	}
+	if (IsDecodingComplete(Session, symbol_canvas)) {
+		return LDPC_OK;
+	}
+	memset(&sys, 0, sizeof(sys));
+	sys.symbolSize = Session->m_symbolSize;
+	sys.deficit = 1;
+
+	// Phase 1: elimination on the matrix alone.
+	if (BuildSystem(Session, &sys) != LDPC_OK ||
+			Eliminate(&sys) != LDPC_OK) {
+		goto end;
+	}
+	sys.nbDense = sys.nbEqus - sys.nbPivots;
+	if (sys.nbDense < sys.nbInactive) {
+		sys.deficit = sys.nbInactive - sys.nbDense;
+		goto end;
+	}
+	sys.words = (sys.nbInactive + 63) / 64;
+	if (sys.words == 0)
+		sys.words = 1;
+	if (((sys.pivotBits = (UINT64*)calloc((size_t)sys.nbEqus * sys.words, sizeof(UINT64))) == NULL) ||
+			((sys.denseEqu = (int*)malloc((sys.nbDense + 1) * sizeof(int))) == NULL) ||
+			((sys.denseBits = (UINT64*)calloc((size_t)(sys.nbDense + 1) * sys.words, sizeof(UINT64))) == NULL) ||
+			((denseCopy = (UINT64*)malloc((size_t)(sys.nbDense + 1) * sys.words * sizeof(UINT64))) == NULL) ||
+			((sys.densePivot = (int*)calloc(sys.nbInactive + 1, sizeof(int))) == NULL) ||
+			((sys.isDensePivot = (char*)calloc(sys.nbDense + 1, sizeof(char))) == NULL) ||
+			((sys.rhs = (void**)calloc(sys.nbEqus, sizeof(void*))) == NULL) ||
+			((sys.rhsData = (UINT8**)calloc(sys.nbEqus, sizeof(UINT8*))) == NULL)) {
+		goto end;
+	}
+
+	// Phase 2: rewrite the system over the inactivated variables, and
+	// check that it has a unique solution.
+	for (i = 0; i < sys.nbPivots; i++) {
+		equ = sys.pivotOrder[i];
+		SubstituteBits(&sys, equ, sys.pivotBits + (size_t)equ * sys.words);
+	}
+	sys.nbDense = 0;
+	for (equ = 0; equ < sys.nbEqus; equ++) {
+		if (sys.equPivot[equ] >= 0)
+			continue;
+		SubstituteBits(&sys, equ, sys.denseBits + (size_t)sys.nbDense * sys.words);
+		sys.denseEqu[sys.nbDense++] = equ;
+	}
+	memcpy(denseCopy, sys.denseBits, (size_t)sys.nbDense * sys.words * sizeof(UINT64));
+	if ((missing = DenseElimination(&sys, denseCopy, false)) != 0) {
+		// not yet, more symbols are needed
+		if (missing > 0)
+			sys.deficit = missing;
+		goto end;
+	}
+	for (c = 0; c < sys.nbInactive; c++) {
+		sys.isDensePivot[sys.densePivot[c]] = true;
+	}
+
+	// Phase 3: same thing on symbols. First the pivot equations, in
+	// pivot order, then the dense rows that are pivots.
+	for (i = 0; i < sys.nbPivots; i++) {
+		equ = sys.pivotOrder[i];
+		if ((sys.rhs[equ] = InitRhs(Session, symbol_canvas, &sys, equ)) == NULL)
+			goto end;
+		SubstituteSymbols(Session, &sys, equ, false);
+	}
+	for (i = 0; i < sys.nbDense; i++) {
+		if (!sys.isDensePivot[i])
+			continue;
+		equ = sys.denseEqu[i];
+		if ((sys.rhs[equ] = InitRhs(Session, symbol_canvas, &sys, equ)) == NULL)
+			goto end;
+		SubstituteSymbols(Session, &sys, equ, false);
+	}
+	DenseElimination(&sys, sys.denseBits, true);
+	// back-substitution: rhs of the pivot of column c becomes the value
+	// of the c-th inactivated variable.
+	for (c = sys.nbInactive - 1; c >= 0; c--) {
+		i = sys.densePivot[c];
+		bits = sys.denseBits + (size_t)i * sys.words;
+		for (c2 = c + 1; c2 < sys.nbInactive; c2++) {
+			if (BIT_GET(bits, c2)) {
+				AddToSymbol(sys.rhsData[sys.denseEqu[i]],
+						sys.rhsData[sys.denseEqu[sys.densePivot[c2]]], Session->m_symbolSize);
+			}
+		}
+	}
+	// pivoted variables: the rhs of a pivot equation still lacks the
+	// inactivated variables it depends on (its pivotBits row), which
+	// are often many. Rather than adding them, go back to the known part
+	// of each equation (in reverse pivot order, so that the pivots it
+	// uses still hold their own partial sums), then add the values of
+	// all its other variables (in pivot order, so that they are known).
+	for (i = sys.nbPivots - 1; i >= 0; i--) {
+		SubstituteSymbols(Session, &sys, sys.pivotOrder[i], false);
+	}
+	for (i = 0; i < sys.nbPivots; i++) {
+		SubstituteSymbols(Session, &sys, sys.pivotOrder[i], true);
+	}
+	for (var = 0; var < sys.nbVars; var++) {
+		seqno = GetSymbolSeqno(Session, sys.varCol[var]);
+		if (!IsSourceSymbol(Session, seqno))
+			continue;
+		if (sys.varStatus[var] == VAR_PIVOT) {
+			equ = sys.varIndex[var];
+		} else {
+			equ = sys.denseEqu[sys.densePivot[sys.varIndex[var]]];
+		}
+		if (Session->m_memoryCallbacks.decodedSymbol != NULL) {
+			// stored where the application tells
+			if ((dst = AllocDecodedSymbol(Session, seqno)) == NULL)
+				goto end;
+			memcpy(GetBufferPtrOnly(Session, dst), sys.rhsData[equ], Session->m_symbolSize);
+		} else {
+			dst = sys.rhs[equ];
+			sys.rhs[equ] = NULL;	// now in the canvas
+		}
+		StoreBuffer(Session, dst);
+		MarkSymbolKnown(Session, seqno);
+		symbol_canvas[seqno] = dst;
+		Session->m_symbolLengths[seqno] = Session->m_symbolSize;
+		Session->m_ownedSourceSymbols[seqno] = dst;
+		SourceSymbolAvailable(Session, symbol_canvas, seqno);
+	}
+	ret = LDPC_OK;
+
+end:
+	if (ret != LDPC_OK) {
+		// each new symbol removes one variable at most, which
+		// lowers the deficit by one at most: no need to try again
+		// before (see DecodingStep).
+		Session->m_mlRetryAt = Session->m_nbReceived + sys.deficit;
+	}
+	free(denseCopy);
+	FreeSystem(Session, &sys);
+	return ret;
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ldpc_framing.h"
+
+
+/******************************************************************************
+ * ldpc_frame_set_data_length: Sets the data length of a source symbol.
+ * => See header file for more informations.
+ */
+	unsigned int
+ldpc_frame_set_data_length	(void		*symbol,
+				 unsigned int	dataLength)
+{
+	unsigned short	len = (unsigned short)dataLength;
+
+	memcpy(symbol, &len, sizeof(len));
+	return dataLength + LDPC_FRAME_PREFIX;
+}
+
+
+/******************************************************************************
+ * ldpc_frame_get_data_length: Gets the data length of a source symbol.
+ * => See header file for more informations.
+ */
+	int
+ldpc_frame_get_data_length	(void		*symbol,
+				 unsigned int	symbolLength,
+				 unsigned int	symbolSize)
+{
+	unsigned short	len = 0;
+	unsigned int	end;
+
+	// the prefix itself may be past the symbol length
+	memcpy(&len, symbol, (symbolLength < LDPC_FRAME_PREFIX) ? symbolLength : LDPC_FRAME_PREFIX);
+	end = len + LDPC_FRAME_PREFIX;
+	if (end > symbolSize)
+		return -1;
+	if (end > symbolLength)
+		memset((unsigned char*)symbol + symbolLength, 0, end - symbolLength);
+	return len;
+}
+
+
+/******************************************************************************
+ * ldpc_frame_write: Builds the packet of a symbol.
+ * => See header file for more informations.
+ */
+	int
+ldpc_frame_write	(void		*packet,
+			 unsigned int	packetSize,
+			 const LDPC_head *head,
+			 const void	*symbol,
+			 unsigned int	symbolLength)
+{
+	LDPC_head	h = *head;
+	unsigned int	length = sizeof(LDPC_head) + symbolLength;
+
+	if (length > packetSize || length > 0xffff || length > h.longest_length)
+		return -1;
+	h.current_length = (unsigned short)length;
+	memcpy(packet, &h, sizeof(h));
+	memcpy((unsigned char*)packet + sizeof(h), symbol, symbolLength);
+	return (int)length;
+}
+
+
+/******************************************************************************
+ * ldpc_frame_read: Parses a packet.
+ * => See header file for more informations.
+ */
+	int
+ldpc_frame_read		(void		*packet,
+			 int		packetLength,
+			 LDPC_head	*head,
+			 void		**symbol,
+			 unsigned int	*symbolLength)
+{
+	if (packetLength < (int)sizeof(LDPC_head))
+		return -1;
+	memcpy(head, packet, sizeof(LDPC_head));
+	if (head->current_length < sizeof(LDPC_head) ||
+			head->current_length > packetLength ||
+			head->current_length > head->longest_length)
+		return -1;
+	*symbol = (unsigned char*)packet + sizeof(LDPC_head);
+	*symbolLength = head->current_length - sizeof(LDPC_head);
+	return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef LDPC_FRAMING_H
+#define LDPC_FRAMING_H
+
+#include "ldpc_fec.h"
+
+/*
+ * Wire format of the symbols: the codec only handles plain symbols and
+ * their lengths, this layer turns them into packets and back.
+ *
+ * A packet is an LDPC_head followed by the first current_length bytes of
+ * the symbol (current_length being counted from the start of the packet),
+ * the following ones being zero. The symbol size is given by longest_length
+ * (also counted from the start of the packet).
+ *
+ * The length of the data carried by a source symbol must survive decoding:
+ * it is stored in the LDPC_FRAME_PREFIX first bytes of the symbol, which
+ * are protected by the code like the rest of the symbol, and the data
+ * follows (see LDPC_FRAME_DATA).
+ */
+
+typedef struct {
+	unsigned int 	type_flag:1;	// 1 for a parity symbol
+	unsigned int 	group_id:31;
+	unsigned int 	sequence_no;
+	unsigned short 	total_data;	// k
+	unsigned short 	total_fec;	// n-k
+	unsigned short 	longest_length;	// sizeof(LDPC_head) + symbol size
+	unsigned short 	current_length;	// length of the packet
+}LDPC_head;
+
+/* Bytes of a source symbol holding the length of its data. */
+#define LDPC_FRAME_PREFIX	sizeof(unsigned short)
+
+/* Data of a source symbol. */
+#define LDPC_FRAME_DATA(symbol)	((unsigned char*)(symbol) + LDPC_FRAME_PREFIX)
+
+/* Symbol size needed for source data of at most maxData bytes. */
+#define LDPC_FRAME_SYMBOL_SIZE(maxData)	((maxData) + LDPC_FRAME_PREFIX)
+
+/**
+ * Sets the length of the data of a source symbol (written at
+ * LDPC_FRAME_DATA(symbol) by the caller).
+ * @param symbol	(IN-OUT) source symbol.
+ * @param dataLength	(IN) length of the data, less than 65536.
+ * @return		length of the symbol, to give to the codec.
+ */
+unsigned int	ldpc_frame_set_data_length	(void		*symbol,
+						 unsigned int	dataLength);
+
+/**
+ * Returns the length of the data of a source symbol, received or rebuilt.
+ * The bytes of the data past the symbol length, which are zero but may
+ * not be initialized in a rebuilt symbol, are cleared.
+ * @param symbol	(IN-OUT) source symbol.
+ * @param symbolLength	(IN) length of the symbol (see GetSymbolLength).
+ * @param symbolSize	(IN) size of the symbol buffer.
+ * @return		length of the data, or -1 if it does not fit in the
+ *			symbol.
+ */
+int	ldpc_frame_get_data_length	(void		*symbol,
+					 unsigned int	symbolLength,
+					 unsigned int	symbolSize);
+
+/**
+ * Builds the packet of a symbol.
+ * @param packet	(OUT) packet buffer.
+ * @param packetSize	(IN) size of the packet buffer.
+ * @param head		(IN) header of the packet: all fields but
+ *			current_length must be set.
+ * @param symbol	(IN) symbol.
+ * @param symbolLength	(IN) length of the symbol.
+ * @return		length of the packet, or -1 if it does not fit in
+ *			packetSize bytes or in the header.
+ */
+int	ldpc_frame_write	(void		*packet,
+				 unsigned int	packetSize,
+				 const LDPC_head *head,
+				 const void	*symbol,
+				 unsigned int	symbolLength);
+
+/**
+ * Parses a packet. The symbol is not copied: it points into the packet,
+ * and is aligned as much as the packet buffer is (the header being 16
+ * bytes long).
+ * @param packet	(IN) packet received.
+ * @param packetLength	(IN) length of the packet.
+ * @param head		(OUT) header of the packet.
+ * @param symbol	(OUT) symbol carried by the packet.
+ * @param symbolLength	(OUT) length of the symbol.
+ * @return		0, or -1 if the packet is truncated or inconsistent.
+ */
+int	ldpc_frame_read		(void		*packet,
+				 int		packetLength,
+				 LDPC_head	*head,
+				 void		**symbol,
+				 unsigned int	*symbolLength);
+
+#endif
@@ -1,159 +1,423 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "ldpc_group.h"
 
+/*
+ * Fibonacci hashing of the 31 bit group id on log2(nbSlots) bits: the high
+ * bits of the product, which depend on all the bits of the id (the low
+ * ones only depend on the low bits of the id).
+ */
+#define GROUP_HASH(table,id)	((unsigned int)(GROUP_ID(id) * 2654435761U) >> (table)->hashShift)
+
 LDPC_group_list* group_list_init(unsigned int group_id, unsigned int total_pkt)
 {
-	LDPC_group_list *head;
-	int i;
+	LDPC_group_list *group;
 
-	head = (LDPC_group_list *)malloc(sizeof(LDPC_group_list));
-	if(NULL != head)
+	group = (LDPC_group_list *)malloc(sizeof(LDPC_group_list));
+	if(NULL == group)
 	{
-		head->next = NULL;
-		head->group_id = group_id;
-		head->total_pkt = total_pkt;
-		head->packet = (char **)malloc(total_pkt*sizeof(char*));
-		if(NULL == head->packet)
-		{
-			printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
-			free(head);
-			head = NULL;
-		}
-		head->Session = (LDPCFecSession *)malloc(sizeof(LDPCFecSession));
-		if(NULL == head->Session)
-		{
-			printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
-			free(head->packet);
-			free(head);
-			head = NULL;
-		}
-		memset(head->packet, 0, total_pkt*sizeof(char *));
-		//for(i=0; i<total_pkt; i++)
-		//	head->packet[i] = NULL;
-		memset(head->Session, 0, sizeof(LDPCFecSession));
+		printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
+		return NULL;
+	}
+	group->group_id = GROUP_ID(group_id);
+	group->total_pkt = total_pkt;
+	group->created = 0;
+	group->last_activity = 0;
+	group->timer_next = NULL;
+	group->timer_prev = NULL;
+	group->timer_slot = NULL;
+	group->packet = (char **)calloc(total_pkt, sizeof(char*));
+	group->Session = (LDPCFecSession *)calloc(1, sizeof(LDPCFecSession));
+	if(NULL == group->packet || NULL == group->Session)
+	{
+		printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
+		free(group->packet);
+		free(group->Session);
+		free(group);
+		return NULL;
 	}
-	return head;
+	return group;
 }
 
-LDPC_group_list* group_list_search(LDPC_group_list *head, char *is_new, unsigned int group_id, unsigned int total_pkt)
+void group_list_free(LDPC_group_list *group)
 {
-	LDPC_group_list *P, *N=head;
-	int i;
+	if(NULL == group)
+		return;
+	// packets stored by the decoder belong to the session, and are
+	// released by EndSession
+	if(IsInitialized(group->Session))
+		EndSession(group->Session);
+	free(group->packet);
+	free(group->Session);
+	free(group);
+}
 
-	*is_new = 0;
+LDPC_group_table* group_table_init(unsigned int size)
+{
+	LDPC_group_table *table;
+	unsigned int nbSlots = GROUP_TABLE_MIN_SIZE;
+	unsigned int hashShift;
 
-	while(N->next != NULL)
+	// keep the table at most half full
+	while(nbSlots < 2 * size)
+		nbSlots <<= 1;
+	for(hashShift = 32; (1U << (32 - hashShift)) < nbSlots; hashShift--)
+		;
+	table = (LDPC_group_table *)malloc(sizeof(LDPC_group_table));
+	if(NULL == table)
+		return NULL;
+	table->slots = (LDPC_group_list **)calloc(nbSlots, sizeof(LDPC_group_list*));
+	if(NULL == table->slots)
 	{
-		if(N->group_id != group_id)
-			N = N->next;
-		else
-			return N;
+		printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
+		free(table);
+		return NULL;
 	}
-	if(N->group_id == group_id)
-		return N;
+	table->nbSlots = nbSlots;
+	table->hashShift = hashShift;
+	table->nbGroups = 0;
+	table->idleTimeout = 0;
+	table->deadline = 0;
+	table->evictCallback = NULL;
+	table->evictContext = NULL;
+	table->now = 0;
+	table->nbTimers = 0;
+	memset(table->wheel, 0, sizeof(table->wheel));
+	table->spares = NULL;
+	table->nbSpares = 0;
+	table->maxSpares = 0;
+	return table;
+}
 
-	*is_new = 1;
+/*
+ * Returns the time at which a group times out, 0 if never.
+ */
+static unsigned long group_expiry(LDPC_group_table *table, LDPC_group_list *group)
+{
+	unsigned long expiry = 0;
+
+	if(table->idleTimeout != 0)
+		expiry = group->last_activity + table->idleTimeout;
+	if(table->deadline != 0 && (expiry == 0 || group->created + table->deadline < expiry))
+		expiry = group->created + table->deadline;
+	return expiry;
+}
+
+/*
+ * Puts a group in the wheel slot of its expiry time: level l is the first
+ * one whose range covers the delay, and the slot is given by the bits of
+ * the expiry time for this level.
+ */
+static void timer_insert(LDPC_group_table *table, LDPC_group_list *group, unsigned long expiry)
+{
+	unsigned long delay;
+	LDPC_group_list **slot;
+	int level;
 
-	P = (LDPC_group_list *)malloc(sizeof(LDPC_group_list));   //申请头结点空间  
-	if(NULL != P)
+	// a timer due now goes in the slot about to be processed (cascading)
+	if(expiry < table->now)
+		expiry = table->now;
+	delay = expiry - table->now;
+	for(level = 0; level < GROUP_WHEEL_LEVELS - 1; level++)
 	{
-		P->next = NULL;
-		P->group_id = group_id;
-		P->total_pkt = total_pkt;
-		P->packet = (char **)malloc(total_pkt*sizeof(char*));
-		if(NULL == P->packet)
-		{
-			printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
-			free(P);
-			P = NULL;
-		}
-		P->Session = (LDPCFecSession *)malloc(sizeof(LDPCFecSession));
-		if(NULL == P->Session)
-		{
-			printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
-			free(P->packet);
-			free(P);
-			P = NULL;
-		}
-		//for(i=0; i<total_pkt; i++)
-		//	P->packet[i] = NULL;
-		memset(P->packet, 0, total_pkt*sizeof(char *));
-		memset(P->Session, 0, sizeof(LDPCFecSession));
+		if(delay < (1UL << (GROUP_WHEEL_BITS * (level + 1))))
+			break;
+	}
+	if(delay >= (1UL << (GROUP_WHEEL_BITS * GROUP_WHEEL_LEVELS)))
+	{
+		// too far away: it will go through the last level again
+		expiry = table->now + (1UL << (GROUP_WHEEL_BITS * GROUP_WHEEL_LEVELS)) - 1;
 	}
+	slot = &table->wheel[level][(expiry >> (GROUP_WHEEL_BITS * level)) & (GROUP_WHEEL_SIZE - 1)];
+	group->timer_prev = NULL;
+	group->timer_next = *slot;
+	if(NULL != *slot)
+		(*slot)->timer_prev = group;
+	*slot = group;
+	group->timer_slot = slot;
+	table->nbTimers++;
+}
+
+static void timer_remove(LDPC_group_table *table, LDPC_group_list *group)
+{
+	if(NULL == group->timer_slot)
+		return;
+	if(NULL != group->timer_prev)
+		group->timer_prev->timer_next = group->timer_next;
 	else
+		*group->timer_slot = group->timer_next;
+	if(NULL != group->timer_next)
+		group->timer_next->timer_prev = group->timer_prev;
+	group->timer_next = NULL;
+	group->timer_prev = NULL;
+	group->timer_slot = NULL;
+	table->nbTimers--;
+}
+
+/*
+ * Returns the slot of a group id: the slot holding this group, or the empty
+ * slot ending its probe sequence if it is not in the table.
+ */
+static unsigned int group_table_slot(LDPC_group_table *table, unsigned int group_id)
+{
+	unsigned int s = GROUP_HASH(table, group_id);
+
+	group_id = GROUP_ID(group_id);
+	while(NULL != table->slots[s] && table->slots[s]->group_id != group_id)
+		s = (s + 1) & (table->nbSlots - 1);
+	return s;
+}
+
+/*
+ * Doubles the number of slots, and rehashes all the groups.
+ */
+static int group_table_grow(LDPC_group_table *table)
+{
+	LDPC_group_list **old = table->slots;
+	unsigned int oldSize = table->nbSlots;
+	unsigned int i;
+
+	table->slots = (LDPC_group_list **)calloc(2 * oldSize, sizeof(LDPC_group_list*));
+	if(NULL == table->slots)
+	{
 		printf("[%s:%d] malloc err!\n", __FILE__, __LINE__);
-	N->next = P;
-	return P;
-}
-
-////////////////////////////////////////////   
-////单链表的删除，在链表中删除值为x的元素  
-void group_list_delete(LDPC_group_list **head, unsigned int group_id)  
-{  
-	LDPC_group_list *p,*pre, *tmp;                   //pre为前驱结点，p为查找的结点。   
-	int i;
-	
-	p = *head;  
-	while(NULL != p)              //查找值为x的元素   
-	{    
-		if(p->group_id == group_id)
+		table->slots = old;
+		return -1;
+	}
+	table->nbSlots = 2 * oldSize;
+	table->hashShift--;
+	for(i = 0; i < oldSize; i++)
+	{
+		if(NULL != old[i])
+			table->slots[group_table_slot(table, old[i]->group_id)] = old[i];
+	}
+	free(old);
+	return 0;
+}
+
+LDPC_group_list* group_table_find(LDPC_group_table *table, unsigned int group_id)
+{
+	return table->slots[group_table_slot(table, group_id)];
+}
+
+/*
+ * Takes a spare group with total_pkt packets out of the spare list, and
+ * gives it the new id. Returns NULL if there is none.
+ */
+static LDPC_group_list* spare_take(LDPC_group_table *table, unsigned int group_id, unsigned int total_pkt)
+{
+	LDPC_group_list **prev, *group;
+
+	for(prev = &table->spares; NULL != (group = *prev); prev = &group->timer_next)
+	{
+		if(group->total_pkt == total_pkt)
 		{
-			break;
+			*prev = group->timer_next;
+			table->nbSpares--;
+			group->group_id = GROUP_ID(group_id);
+			group->timer_next = NULL;
+			return group;
 		}
-		pre = p;   
-		p = p->next;  
 	}
+	return NULL;
+}
 
-	if(p == NULL)
+/*
+ * Keeps a deleted group as a spare if possible, frees it otherwise.
+ */
+static void spare_put(LDPC_group_table *table, LDPC_group_list *group)
+{
+	if(table->nbSpares >= table->maxSpares || !IsInitialized(group->Session)
+			|| LDPC_OK != ResetSession(group->Session))
 	{
-		printf("[%s:%d] can't find the group id!\n", __FILE__, __LINE__);
+		group_list_free(group);
 		return;
 	}
-	if(p==*head)
-		*head = p->next;
-	else
-		pre->next = p->next;          //删除操作，将其前驱next指向其后继。  
-	for(i=0; i<p->total_pkt; i++)
+	// the packets stored by the decoder went back with the reset
+	memset(group->packet, 0, group->total_pkt * sizeof(char*));
+	group->created = 0;
+	group->last_activity = 0;
+	group->timer_next = table->spares;
+	table->spares = group;
+	table->nbSpares++;
+}
+
+LDPC_group_list* group_table_search(LDPC_group_table *table, char *is_new, unsigned int group_id, unsigned int total_pkt)
+{
+	LDPC_group_list *group;
+	unsigned int s;
+
+	*is_new = 0;
+	s = group_table_slot(table, group_id);
+	if(NULL != table->slots[s])
+	{
+		// the timer is not moved: this is checked when it fires
+		table->slots[s]->last_activity = table->now;
+		return table->slots[s];
+	}
+
+	if(2 * (table->nbGroups + 1) > table->nbSlots)
+	{
+		if(group_table_grow(table) < 0)
+			return NULL;
+		s = group_table_slot(table, group_id);
+	}
+	group = spare_take(table, group_id, total_pkt);
+	if(NULL == group)
+		group = group_list_init(group_id, total_pkt);
+	if(NULL == group)
+		return NULL;
+	table->slots[s] = group;
+	table->nbGroups++;
+	*is_new = 1;
+	group->created = table->now;
+	group->last_activity = table->now;
+	if(0 != group_expiry(table, group))
+		timer_insert(table, group, group_expiry(table, group));
+	return group;
+}
+
+/*
+ * Takes a group out of the table and of the timing wheel. Returns it, or
+ * NULL if it is not in the table.
+ */
+static LDPC_group_list* group_table_remove(LDPC_group_table *table, unsigned int group_id)
+{
+	unsigned int mask = table->nbSlots - 1;
+	unsigned int hole, s, home;
+	LDPC_group_list *group;
+
+	hole = group_table_slot(table, group_id);
+	group = table->slots[hole];
+	if(NULL == group)
 	{
-		if(p->packet[i] != NULL)
+		printf("[%s:%d] can't find the group id!\n", __FILE__, __LINE__);
+		return NULL;
+	}
+	table->slots[hole] = NULL;
+	table->nbGroups--;
+	timer_remove(table, group);
+	// Backward shift deletion: move back the following groups of the
+	// cluster whose probe sequence goes through the hole, so that no
+	// tombstone is needed.
+	for(s = (hole + 1) & mask; NULL != table->slots[s]; s = (s + 1) & mask)
+	{
+		home = GROUP_HASH(table, table->slots[s]->group_id);
+		if(((s - home) & mask) >= ((s - hole) & mask))
 		{
-			free(p->packet[i]);
-			p->packet[i] = NULL;
+			table->slots[hole] = table->slots[s];
+			table->slots[s] = NULL;
+			hole = s;
 		}
 	}
-	if(IsInitialized(p->Session))
-		EndSession(p->Session);
-	free(p->packet);
-	free(p->Session);
-	free(p);
-	p=NULL;
-	
-	tmp = *head;  
-	while(NULL != tmp)              //查找值为x的元素   
-	{    
-		tmp = tmp->next;  
-	}
-
-	return;
-}
-
-//didn't think about free p->packet[i] like group_list_delete
-void group_list_deinit(LDPC_group_list *head)  
-{  
-	LDPC_group_list *p,*pre;                   //pre为前驱结点，p为查找的结点。   
-	p = head;  
-	while(p!=NULL)              //查找值为x的元素   
-	{     
-		if( IsInitialized(p->Session) ) 
-			EndSession(p->Session);
-		pre = p;   
-		p = p->next;  
-		free(pre->packet);
-		free(pre->Session);
-		free(pre);
-		pre=NULL;
-	}
-	
-	return;
+	return group;
+}
+
+void group_table_delete(LDPC_group_table *table, unsigned int group_id)
+{
+	LDPC_group_list *group = group_table_remove(table, group_id);
+
+	if(NULL != group)
+		spare_put(table, group);
+}
+
+void group_table_set_timeouts(LDPC_group_table *table, unsigned long idle_timeout, unsigned long deadline, group_evict_callback callback, void *context)
+{
+	table->idleTimeout = idle_timeout;
+	table->deadline = deadline;
+	table->evictCallback = callback;
+	table->evictContext = context;
+}
+
+void group_table_set_spares(LDPC_group_table *table, unsigned int max_spares)
+{
+	LDPC_group_list *group;
+
+	table->maxSpares = max_spares;
+	while(table->nbSpares > max_spares)
+	{
+		group = table->spares;
+		table->spares = group->timer_next;
+		table->nbSpares--;
+		group_list_free(group);
+	}
+}
+
+int group_table_expire(LDPC_group_table *table, unsigned long now)
+{
+	LDPC_group_list *group;
+	unsigned long expiry;
+	unsigned int idx;
+	int level, evicted = 0;
+
+	while(table->now < now)
+	{
+		if(0 == table->nbTimers)
+		{
+			// nothing to do until now
+			table->now = now;
+			break;
+		}
+		table->now++;
+		// When a level wraps around, the groups of the current slot of
+		// the next level are spread over the lower levels.
+		for(level = 1; level < GROUP_WHEEL_LEVELS; level++)
+		{
+			if(0 != (table->now & ((1UL << (GROUP_WHEEL_BITS * level)) - 1)))
+				break;
+			idx = (table->now >> (GROUP_WHEEL_BITS * level)) & (GROUP_WHEEL_SIZE - 1);
+			while(NULL != (group = table->wheel[level][idx]))
+			{
+				timer_remove(table, group);
+				timer_insert(table, group, group_expiry(table, group));
+			}
+		}
+		idx = table->now & (GROUP_WHEEL_SIZE - 1);
+		while(NULL != (group = table->wheel[0][idx]))
+		{
+			timer_remove(table, group);
+			expiry = group_expiry(table, group);
+			if(expiry > table->now)
+			{
+				// packets received since the timer was set
+				timer_insert(table, group, expiry);
+				continue;
+			}
+			if(NULL != table->evictCallback)
+			{
+				table->evictCallback(table->evictContext, group,
+						(table->deadline != 0 && group->created + table->deadline <= table->now) ?
+						GROUP_EVICT_DEADLINE : GROUP_EVICT_IDLE);
+			}
+			// not kept as a spare: eviction releases all the
+			// memory of the group
+			group_list_free(group_table_remove(table, group->group_id));
+			evicted++;
+		}
+	}
+	return evicted;
+}
+
+LDPC_group_list* group_table_next(LDPC_group_table *table, unsigned int *pos)
+{
+	while(*pos < table->nbSlots)
+	{
+		if(NULL != table->slots[(*pos)++])
+			return table->slots[*pos - 1];
+	}
+	return NULL;
+}
+
+void group_table_deinit(LDPC_group_table *table)
+{
+	unsigned int i;
+
+	if(NULL == table)
+		return;
+	for(i = 0; i < table->nbSlots; i++)
+		group_list_free(table->slots[i]);
+	group_table_set_spares(table, 0);
+	free(table->slots);
+	free(table);
 }
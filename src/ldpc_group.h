@@ -3,17 +3,167 @@
 
 #include "ldpc_fec.h"
 
+/*
+ * group_id is a 31 bit field of LDPC_head: ids are compared modulo 2^31, so
+ * that a sender whose counter wraps around keeps addressing the right groups.
+ */
+#define GROUP_ID_MASK		0x7fffffffU
+#define GROUP_ID(id)		((unsigned int)(id) & GROUP_ID_MASK)
+
+/* Initial number of slots of a group table (power of 2). */
+#define GROUP_TABLE_MIN_SIZE	64
+
+/*
+ * Hierarchical timing wheel: GROUP_WHEEL_LEVELS wheels of GROUP_WHEEL_SIZE
+ * slots, a slot of level l covering GROUP_WHEEL_SIZE^l ticks (a tick being
+ * the time unit used by the caller, e.g. ms). Timers further away than
+ * GROUP_WHEEL_SIZE^GROUP_WHEEL_LEVELS ticks are cascaded again later.
+ */
+#define GROUP_WHEEL_BITS	6
+#define GROUP_WHEEL_SIZE	(1 << GROUP_WHEEL_BITS)
+#define GROUP_WHEEL_LEVELS	4
+
 typedef struct group_list {
-	struct group_list *next;
 	unsigned int group_id;
 	unsigned int total_pkt;
 	char** 	packet;
 	LDPCFecSession *Session;
+	unsigned long created;		// time of the first packet
+	unsigned long last_activity;	// time of the last packet
+	struct group_list *timer_next;	// other groups of the same wheel slot,
+					// or next spare group
+	struct group_list *timer_prev;
+	struct group_list **timer_slot;	// wheel slot of the group, or NULL
 }LDPC_group_list;
 
+/* Why a group is evicted. */
+typedef enum {
+	GROUP_EVICT_IDLE,	// no packet received during the idle timeout
+	GROUP_EVICT_DEADLINE,	// not decoded within the deadline
+} group_evict_reason;
+
+/*
+ * Function called before an incomplete group is evicted: the group (its
+ * session and packets) is still valid during the call, and freed after.
+ */
+typedef void (*group_evict_callback) (void *context, LDPC_group_list *group, group_evict_reason reason);
+
+/*
+ * Groups being received, indexed by group_id in an open addressing hash
+ * table (linear probing, at most half full), so that finding the group of
+ * a packet, adding and removing a group are O(1).
+ * Groups are also registered in a timing wheel, so that the ones which
+ * cannot be decoded are evicted after a timeout (group_table_set_timeouts).
+ * Deleted groups may be kept as spares, whose sessions are reset and
+ * reused by the next groups (group_table_set_spares).
+ */
+typedef struct {
+	LDPC_group_list **slots;	// Array: nbSlots groups, NULL if empty
+	unsigned int	nbSlots;	// power of 2
+	unsigned int	hashShift;	// 32 - log2(nbSlots)
+	unsigned int	nbGroups;
+
+	unsigned long	idleTimeout;	// in ticks, 0 if none
+	unsigned long	deadline;	// in ticks, 0 if none
+	group_evict_callback evictCallback;
+	void*		evictContext;
+	unsigned long	now;		// current time of the wheel
+	unsigned int	nbTimers;	// groups in the wheel
+	LDPC_group_list	*wheel[GROUP_WHEEL_LEVELS][GROUP_WHEEL_SIZE];
+
+	LDPC_group_list	*spares;	// deleted groups kept for reuse
+	unsigned int	nbSpares;
+	unsigned int	maxSpares;	// 0 if groups are always freed
+} LDPC_group_table;
+
+/**
+ * Allocates a group, with an uninitialized session and no packet.
+ * @return	the group, or NULL if no memory is left.
+ */
 LDPC_group_list* group_list_init(unsigned int group_id, unsigned int total_pkt);
 
-LDPC_group_list* group_list_search(LDPC_group_list *head, char *is_new, unsigned int group_id, unsigned int total_pkt);
+/**
+ * Frees a group: ends its session (which releases the packets stored by
+ * the decoder) and frees the group itself.
+ */
+void group_list_free(LDPC_group_list *group);
+
+/**
+ * Creates an empty group table.
+ * @param size	(IN) expected number of concurrent groups, or 0.
+ * @return	the table, or NULL if no memory is left.
+ */
+LDPC_group_table* group_table_init(unsigned int size);
+
+/**
+ * Returns the group with this id, or NULL.
+ */
+LDPC_group_list* group_table_find(LDPC_group_table *table, unsigned int group_id);
+
+/**
+ * Returns the group with this id, creating it if needed.
+ * This is meant to be called for each packet received: the activity time
+ * of the group is updated (to the time given to the last
+ * group_table_expire call).
+ * @param is_new	(OUT) set to 1 if the group has just been created
+ *			(its session must then be initialized, unless
+ *			IsInitialized is true for a recycled session), 0
+ *			otherwise.
+ * @return	the group, or NULL if no memory is left.
+ */
+LDPC_group_list* group_table_search(LDPC_group_table *table, char *is_new, unsigned int group_id, unsigned int total_pkt);
+
+/**
+ * Removes a group from the table and frees it (see group_list_free), or
+ * keeps it as a spare: its session is then reset (see ResetSession), and
+ * its packets are released.
+ */
+void group_table_delete(LDPC_group_table *table, unsigned int group_id);
+
+/**
+ * Sets the timeouts after which an incomplete group is evicted, i.e. freed
+ * (with its session and packets) and removed from the table. Evicted
+ * groups are never kept as spares (see group_table_set_spares).
+ * Both are in ticks, 0 meaning no timeout. They should be set before the
+ * first group is created: groups created with no timeout are never
+ * evicted.
+ * @param idle_timeout	(IN) maximum time between two packets of a group.
+ * @param deadline	(IN) maximum time between the first packet of a
+ *			group and its deletion.
+ * @param callback	(IN) function called for each evicted group, or NULL.
+ * @param context	(IN) first argument of callback.
+ */
+void group_table_set_timeouts(LDPC_group_table *table, unsigned long idle_timeout, unsigned long deadline, group_evict_callback callback, void *context);
+
+/**
+ * Sets the number of deleted groups kept for reuse, 0 by default (evicted
+ * groups are freed all the same).
+ * A new group reuses a spare group with the same number of packets, whose
+ * session is still initialized with the parameters of its previous group:
+ * recycling saves the matrix and table allocations of InitSession, and
+ * only makes sense when all the groups use the same parameters.
+ * @param max_spares	(IN) maximum number of spare groups.
+ */
+void group_table_set_spares(LDPC_group_table *table, unsigned int max_spares);
+
+/**
+ * Advances the clock of the table, and evicts the groups that timed out.
+ * Must be called regularly, and before the first packet is received since
+ * the first call sets the clock.
+ * @param now	(IN) current time, in ticks, never decreasing.
+ * @return	number of groups evicted.
+ */
+int group_table_expire(LDPC_group_table *table, unsigned long now);
+
+/**
+ * Iterates over the groups of the table: *pos must be 0 for the first call.
+ * The table must not be modified during the iteration.
+ * @return	the next group, or NULL once all groups have been returned.
+ */
+LDPC_group_list* group_table_next(LDPC_group_table *table, unsigned int *pos);
 
-void group_list_delete(LDPC_group_list **head, unsigned int group_id);
+/**
+ * Frees all the groups of the table, the spare ones, and the table itself.
+ */
+void group_table_deinit(LDPC_group_table *table);
 #endif
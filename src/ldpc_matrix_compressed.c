@@ -0,0 +1,364 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "ldpc_matrix_compressed.h"
+#include "ldpc_matrix_qc.h"
+
+/* ALLOCATE A COMPRESSED MATRIX AND ITS ARRAYS IN A SINGLE BLOCK.  The
+   index arrays are left uninitialized. */
+
+	static mod2csr *alloc_csr
+( int n_rows,
+  int n_cols,
+  int nnz
+  )
+{
+	mod2csr *m;
+	size_t ptr_bytes, idx_bytes;
+	char *p;
+
+	m = (mod2csr*)calloc (1, sizeof *m);
+	if (m==0)
+	{ return 0;
+	}
+
+	m->n_rows = n_rows;
+	m->n_cols = n_cols;
+	m->nnz = nnz;
+	m->idx_size = (n_rows<65536 && n_cols<65536) ? 2 : 4;
+
+	ptr_bytes = ((size_t)n_rows + 1 + n_cols + 1) * sizeof(INT32);
+	idx_bytes = (size_t)nnz * m->idx_size;
+
+	m->mem = malloc (ptr_bytes + 2*idx_bytes);
+	if (m->mem==0)
+	{ free(m);
+		return 0;
+	}
+
+	p = (char*)m->mem;
+	m->row_ptr = (INT32*)p;
+	m->col_ptr = m->row_ptr + n_rows + 1;
+	p += ptr_bytes;
+	m->col_idx = p;
+	m->row_idx = p + idx_bytes;
+
+	return m;
+}
+
+
+/* BUILD A COMPRESSED COPY OF A SPARSE MOD2 MATRIX.  The sparse matrix is
+   walked once by row and once by column, so indexes come out sorted. */
+
+	mod2csr *mod2csr_from_sparse
+( mod2sparse *s
+)
+{
+	mod2csr *m;
+	mod2entry *e;
+	int i, j, nnz, p;
+
+	nnz = 0;
+	for (i = 0; i<mod2sparse_rows(s); i++)
+	{ for (e = mod2sparse_first_in_row(s,i); !mod2sparse_at_end(e); e = mod2sparse_next_in_row(e))
+		{ nnz++;
+		}
+	}
+
+	m = alloc_csr(mod2sparse_rows(s), mod2sparse_cols(s), nnz);
+	if (m==0)
+	{ return 0;
+	}
+
+	p = 0;
+	for (i = 0; i<mod2sparse_rows(s); i++)
+	{ m->row_ptr[i] = p;
+		for (e = mod2sparse_first_in_row(s,i); !mod2sparse_at_end(e); e = mod2sparse_next_in_row(e))
+		{ if (m->idx_size==2)
+				((UINT16*)m->col_idx)[p] = (UINT16)mod2sparse_col(e);
+			else
+				((INT32*)m->col_idx)[p] = mod2sparse_col(e);
+			p++;
+		}
+	}
+	m->row_ptr[i] = p;
+
+	p = 0;
+	for (j = 0; j<mod2sparse_cols(s); j++)
+	{ m->col_ptr[j] = p;
+		for (e = mod2sparse_first_in_col(s,j); !mod2sparse_at_end(e); e = mod2sparse_next_in_col(e))
+		{ if (m->idx_size==2)
+				((UINT16*)m->row_idx)[p] = (UINT16)mod2sparse_row(e);
+			else
+				((INT32*)m->row_idx)[p] = mod2sparse_row(e);
+			p++;
+		}
+	}
+	m->col_ptr[j] = p;
+
+	return m;
+}
+
+
+/* BUILD A COMPRESSED COPY OF A QUASI-CYCLIC MATRIX.  The entries of each
+   row and column are computed in increasing order: staircase first, then
+   circulants, which are sorted by block. */
+
+	mod2csr *mod2csr_from_qc
+( mod2qc *q
+)
+{
+	mod2csr *m;
+	int i, j, p, pos, r, c, o, v;
+
+	m = alloc_csr(q->n_rows, q->n_cols, 2*q->n_rows - q->z + q->nnz*q->z);
+	if (m==0)
+	{ return 0;
+	}
+
+#define PUT(idx,at,val) \
+	{ if (m->idx_size==2) ((UINT16*)(idx))[at] = (UINT16)(val); \
+		else ((INT32*)(idx))[at] = (val); }
+
+	pos = 0;
+	for (i = 0; i<q->n_rows; i++)
+	{ m->row_ptr[i] = pos;
+		r = i / q->z;
+		o = i % q->z;
+		if (i>=q->z)
+		{ PUT(m->col_idx, pos, i-q->z); pos++;
+		}
+		PUT(m->col_idx, pos, i); pos++;
+		for (p = mod2qc_row_begin(q,r); p<mod2qc_row_end(q,r); p++)
+		{ v = q->n_rows + mod2qc_row_col(q,p,o);
+			PUT(m->col_idx, pos, v); pos++;
+		}
+	}
+	m->row_ptr[i] = pos;
+
+	pos = 0;
+	for (j = 0; j<q->n_cols; j++)
+	{ m->col_ptr[j] = pos;
+		if (j<q->n_rows)
+		{ PUT(m->row_idx, pos, j); pos++;
+			if (j+q->z<q->n_rows)
+			{ PUT(m->row_idx, pos, j+q->z); pos++;
+			}
+			continue;
+		}
+		c = (j - q->n_rows) / q->z;
+		o = (j - q->n_rows) % q->z;
+		for (p = mod2qc_col_begin(q,c); p<mod2qc_col_end(q,c); p++)
+		{ v = mod2qc_col_row(q,p,o);
+			PUT(m->row_idx, pos, v); pos++;
+		}
+	}
+	m->col_ptr[j] = pos;
+
+#undef PUT
+
+	return m;
+}
+
+
+/* BUILD A COMPRESSED MATRIX FROM A LIST OF ENTRIES.  The nnz entries
+   (rows[p], cols[p]) must all be different, and may come in any order.
+   They are bucket sorted by row, each row being then sorted on its own
+   (rows are short), and spread over the columns row after row, so that
+   indexes come out sorted. */
+
+	mod2csr *mod2csr_from_entries
+( int n_rows,
+  int n_cols,
+  int nnz,
+  const int *rows,
+  const int *cols
+  )
+{
+	mod2csr *m;
+	int *pos, *row_cols;
+	int i, j, p, q;
+
+	m = alloc_csr(n_rows, n_cols, nnz);
+	pos = (int*)malloc(((size_t)(n_rows>n_cols ? n_rows : n_cols) + 1) * sizeof(int));
+	row_cols = (int*)malloc(((size_t)nnz + 1) * sizeof(int));
+	if (m==0 || pos==0 || row_cols==0)
+	{ mod2csr_free(m);
+		free(pos);
+		free(row_cols);
+		return 0;
+	}
+
+	/* Weights of the rows and columns. */
+
+	memset(m->row_ptr, 0, ((size_t)n_rows + 1 + n_cols + 1) * sizeof(INT32));
+	for (p = 0; p<nnz; p++)
+	{ m->row_ptr[rows[p]+1]++;
+		m->col_ptr[cols[p]+1]++;
+	}
+	for (i = 0; i<n_rows; i++)
+	{ m->row_ptr[i+1] += m->row_ptr[i];
+	}
+	for (j = 0; j<n_cols; j++)
+	{ m->col_ptr[j+1] += m->col_ptr[j];
+	}
+
+	/* Columns of each row, sorted by insertion. */
+
+	memcpy(pos, m->row_ptr, (size_t)n_rows * sizeof(int));
+	for (p = 0; p<nnz; p++)
+	{ row_cols[pos[rows[p]]++] = cols[p];
+	}
+	for (i = 0; i<n_rows; i++)
+	{ for (p = m->row_ptr[i]+1; p<m->row_ptr[i+1]; p++)
+		{ j = row_cols[p];
+			for (q = p; q>m->row_ptr[i] && row_cols[q-1]>j; q--)
+			{ row_cols[q] = row_cols[q-1];
+			}
+			row_cols[q] = j;
+		}
+	}
+
+	/* Compressed rows, and rows of each column in increasing order. */
+
+	memcpy(pos, m->col_ptr, (size_t)n_cols * sizeof(int));
+	for (i = 0; i<n_rows; i++)
+	{ for (p = m->row_ptr[i]; p<m->row_ptr[i+1]; p++)
+		{ j = row_cols[p];
+			q = pos[j]++;
+			if (m->idx_size==2)
+			{ ((UINT16*)m->col_idx)[p] = (UINT16)j;
+				((UINT16*)m->row_idx)[q] = (UINT16)i;
+			}
+			else
+			{ ((INT32*)m->col_idx)[p] = j;
+				((INT32*)m->row_idx)[q] = i;
+			}
+		}
+	}
+
+	free(pos);
+	free(row_cols);
+	return m;
+}
+
+
+/* LINK THE ENTRIES OF A COMPRESSED MATRIX.  The entries array of s holds
+   one entry per non-zero of m, and all the rows and columns of s are
+   empty. */
+
+	static void link_entries
+( mod2sparse *s,
+  mod2csr *m
+  )
+{
+	mod2entry *e, *ce;
+	int i, j, p;
+
+	/* Entries are created row after row, each one appended at the end
+	   of its row and of its column, which keeps both lists sorted. */
+
+	for (i = 0; i<mod2csr_rows(m); i++)
+	{ for (p = mod2csr_row_begin(m,i); p<mod2csr_row_end(m,i); p++)
+		{ j = mod2csr_col(m,p);
+			e = &s->entries[p];
+			e->row = i;
+			e->col = j;
+
+			e->left = s->rows[i].left;
+			e->right = &s->rows[i];
+			e->left->right = e;
+			e->right->left = e;
+
+			ce = &s->cols[j];
+			e->up = ce->up;
+			e->down = ce;
+			e->up->down = e;
+			e->down->up = e;
+		}
+	}
+}
+
+
+/* BUILD A SPARSE MOD2 MATRIX FROM A COMPRESSED ONE.  All the entries are
+   allocated in a single array and linked directly, without going through
+   mod2sparse_insert.  The result is an ordinary sparse matrix, whose
+   entries can be deleted or inserted as usual. */
+
+	mod2sparse *mod2sparse_from_csr
+( mod2csr *m
+)
+{
+	mod2sparse *s;
+
+	s = mod2sparse_allocate(mod2csr_rows(m), mod2csr_cols(m));
+
+	if (m->nnz>0)
+	{ s->entries = (mod2entry*)malloc((size_t)m->nnz * sizeof(mod2entry));
+		if (s->entries==0)
+		{ mod2sparse_free(s);
+			free(s);
+			return 0;
+		}
+	}
+
+	link_entries(s, m);
+
+	return s;
+}
+
+
+/* RESET A SPARSE MOD2 MATRIX BUILT FROM A COMPRESSED ONE.  The entries
+   deleted since mod2sparse_from_csr are linked back in place, in a single
+   pass over the matrix, without any allocation.  Fails (returns -1) if s
+   was not built from a matrix of this size, or if entries were inserted
+   in it since. */
+
+	int mod2sparse_reset_from_csr
+( mod2sparse *s,
+  mod2csr *m
+  )
+{
+	mod2entry *e;
+	int i, j;
+
+	if (mod2sparse_rows(s)!=mod2csr_rows(m) || mod2sparse_cols(s)!=mod2csr_cols(m)
+	 || s->blocks!=0 || (m->nnz>0 && s->entries==0))
+	{ return -1;
+	}
+
+	for (i = 0; i<mod2sparse_rows(s); i++)
+	{ e = &s->rows[i];
+		e->left = e->right = e->up = e->down = e;
+	}
+	for (j = 0; j<mod2sparse_cols(s); j++)
+	{ e = &s->cols[j];
+		e->left = e->right = e->up = e->down = e;
+	}
+	s->next_free = 0;
+
+	link_entries(s, m);
+
+	return 0;
+}
+
+
+/* FREE A COMPRESSED MATRIX (the structure itself included). */
+
+	void mod2csr_free
+( mod2csr *m
+)
+{
+	if (m==0)
+	{ return;
+	}
+	if (m->mapped!=0)
+	{ munmap(m->mem, m->mapped);
+	}
+	else
+	{ free(m->mem);
+	}
+	free(m);
+}
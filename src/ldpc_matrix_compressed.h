@@ -0,0 +1,62 @@
+#ifndef LDPC_MATRIX_COMPRESSED__
+#define LDPC_MATRIX_COMPRESSED__
+
+#include <stddef.h>
+
+#include "ldpc_types.h"
+#include "ldpc_matrix_sparse.h"
+
+/**
+ * Immutable compressed copy of a sparse mod2 matrix, stored both by row
+ * (CSR) and by column (CSC).
+ * Entries of row i are at positions row_ptr[i] .. row_ptr[i+1]-1 of col_idx,
+ * entries of column j at positions col_ptr[j] .. col_ptr[j+1]-1 of row_idx,
+ * in increasing order. Indexes are UINT16 when both dimensions are below
+ * 65536, INT32 otherwise (see idx_size), and every array lives in a single
+ * memory block.
+ */
+typedef struct mod2csr
+{
+	int n_rows;		  /* Number of rows in the matrix */
+	int n_cols;		  /* Number of columns in the matrix */
+	int nnz;		  /* Number of non-zero entries */
+	int idx_size;		  /* Size of an index, 2 or 4 bytes */
+
+	INT32 *row_ptr;		  /* n_rows+1 offsets in col_idx */
+	INT32 *col_ptr;		  /* n_cols+1 offsets in row_idx */
+	void *col_idx;		  /* nnz column indexes, row after row */
+	void *row_idx;		  /* nnz row indexes, column after column */
+
+	void *mem;		  /* Block holding all the arrays */
+	size_t mapped;		  /* Size of mem if it is a file mapping
+				     (see ldpc_pchk_file.h), 0 otherwise */
+} mod2csr;
+
+/* MACROS TO GET AT ELEMENTS OF A COMPRESSED MATRIX. */
+
+#define mod2csr_row_begin(m,i) ((m)->row_ptr[i])	/* Range of positions */
+#define mod2csr_row_end(m,i) ((m)->row_ptr[(i)+1])	/* of row i / col j   */
+#define mod2csr_col_begin(m,j) ((m)->col_ptr[j])
+#define mod2csr_col_end(m,j) ((m)->col_ptr[(j)+1])
+
+#define mod2csr_row_weight(m,i) (mod2csr_row_end(m,i) - mod2csr_row_begin(m,i))
+#define mod2csr_col_weight(m,j) (mod2csr_col_end(m,j) - mod2csr_col_begin(m,j))
+
+#define mod2csr_col(m,p) ((m)->idx_size == 2 ? (int)((UINT16*)(m)->col_idx)[p] \
+					      : (int)((INT32*)(m)->col_idx)[p])
+#define mod2csr_row(m,p) ((m)->idx_size == 2 ? (int)((UINT16*)(m)->row_idx)[p] \
+					      : (int)((INT32*)(m)->row_idx)[p])
+
+#define mod2csr_rows(m) ((m)->n_rows)
+#define mod2csr_cols(m) ((m)->n_cols)
+
+/* PROCEDURES TO MANIPULATE COMPRESSED MATRICES. */
+struct mod2qc;
+mod2csr *mod2csr_from_sparse (mod2sparse *);
+mod2csr *mod2csr_from_qc (struct mod2qc *);
+mod2csr *mod2csr_from_entries (int, int, int, const int *, const int *);
+mod2sparse *mod2sparse_from_csr (mod2csr *);
+int mod2sparse_reset_from_csr (mod2sparse *, mod2csr *);
+void mod2csr_free            (mod2csr *);
+
+#endif // #ifndef LDPC_MATRIX_COMPRESSED__
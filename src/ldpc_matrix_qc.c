@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ldpc_matrix_qc.h"
+
+/* SIZE OF THE CIRCULANTS OF A MATRIX.  The largest divisor of both the
+   number of rows and the number of source columns that is at most
+   Mod2qc_max_z and leaves at least Mod2qc_min_blocks block rows, or 1
+   (the matrix is then an ordinary one). */
+
+	int mod2qc_block_size
+( int n_rows,
+  int n_cols
+  )
+{
+	int a, b, t, z;
+
+	a = n_rows;
+	b = n_cols - n_rows;
+	while (b!=0)
+	{ t = a % b;
+		a = b;
+		b = t;
+	}
+
+	for (z = a<Mod2qc_max_z ? a : Mod2qc_max_z; z>1; z--)
+	{ if (a % z==0 && n_rows / z>=Mod2qc_min_blocks)
+		{ return z;
+		}
+	}
+	return 1;
+}
+
+
+/* ALLOCATE A QUASI-CYCLIC MATRIX AND ITS ARRAYS IN A SINGLE BLOCK.  The
+   arrays are left uninitialized.  The size of the circulants must divide
+   both the number of rows and the number of source columns. */
+
+	mod2qc *mod2qc_allocate
+( int n_rows,
+  int n_cols,
+  int z,
+  int nnz
+  )
+{
+	mod2qc *m;
+
+	if (z<=0 || n_rows<=0 || n_cols<=n_rows || n_rows % z!=0 || (n_cols-n_rows) % z!=0)
+	{ fprintf(stderr,"mod2qc_allocate: Invalid block size %d for a %dx%d matrix\n",
+			z, n_rows, n_cols);
+		return 0;
+	}
+
+	m = (mod2qc*)calloc (1, sizeof *m);
+	if (m==0)
+	{ return 0;
+	}
+
+	m->n_rows = n_rows;
+	m->n_cols = n_cols;
+	m->z = z;
+	m->mb = n_rows / z;
+	m->kb = (n_cols - n_rows) / z;
+	m->nnz = nnz;
+
+	m->mem = malloc (((size_t)m->kb + 1 + m->mb + 1 + 4*(size_t)nnz) * sizeof(INT32));
+	if (m->mem==0)
+	{ free(m);
+		return 0;
+	}
+
+	m->col_ptr = (INT32*)m->mem;
+	m->col_blk = m->col_ptr + m->kb + 1;
+	m->col_shift = m->col_blk + nnz;
+	m->row_ptr = m->col_shift + nnz;
+	m->row_blk = m->row_ptr + m->mb + 1;
+	m->row_shift = m->row_blk + nnz;
+
+	return m;
+}
+
+
+/* SET THE CIRCULANTS OF EACH BLOCK ROW FROM THOSE OF EACH BLOCK COLUMN,
+   which must be set.  Block columns are walked in order, so that those
+   of each block row come out sorted. */
+
+	void mod2qc_index_rows
+( mod2qc *m
+)
+{
+	int c, p, q, r;
+
+	memset(m->row_ptr, 0, ((size_t)m->mb + 1) * sizeof(INT32));
+	for (p = 0; p<m->nnz; p++)
+	{ m->row_ptr[m->col_blk[p]+1]++;
+	}
+	for (r = 0; r<m->mb; r++)
+	{ m->row_ptr[r+1] += m->row_ptr[r];
+	}
+
+	/* row_ptr[r] is used as the insertion point of block row r, then
+	   shifted back. */
+
+	for (c = 0; c<m->kb; c++)
+	{ for (p = mod2qc_col_begin(m,c); p<mod2qc_col_end(m,c); p++)
+		{ q = m->row_ptr[m->col_blk[p]]++;
+			m->row_blk[q] = c;
+			m->row_shift[q] = m->col_shift[p];
+		}
+	}
+	for (r = m->mb; r>0; r--)
+	{ m->row_ptr[r] = m->row_ptr[r-1];
+	}
+	m->row_ptr[0] = 0;
+}
+
+
+/* FREE A QUASI-CYCLIC MATRIX (the structure itself included). */
+
+	void mod2qc_free
+( mod2qc *m
+)
+{
+	if (m==0)
+	{ return;
+	}
+	free(m->mem);
+	free(m);
+}
@@ -0,0 +1,85 @@
+#ifndef LDPC_MATRIX_QC__
+#define LDPC_MATRIX_QC__
+
+#include "ldpc_types.h"
+#include "ldpc_matrix_compressed.h"
+
+/**
+ * Quasi-cyclic parity check matrix, described by its base matrix.
+ * The source part of the matrix is made of mb x kb square blocks of
+ * z x z bits, each of them either zero or a circulant: the identity
+ * shifted by s columns, i.e. with the entries (i, (i+s) mod z). Only the
+ * block row and shift of the circulants are stored, so that the
+ * description takes a few kilobytes whatever the size of the matrix, and
+ * the entries are computed instead of being loaded (see mod2qc_col_row
+ * and mod2qc_row_col).
+ * The parity part is a staircase of blocks (block dual diagonal): parity
+ * column i has the entries (i, i) and (i+z, i), so that parity symbol i
+ * depends on parity symbol i-z, as in LDPC-Staircase matrices with blocks
+ * instead of bits. A staircase of bits would link the successive rows of
+ * each circulant, making the same short cycles everywhere. As usual, the
+ * n_rows parity columns come first, then the source ones.
+ * Circulants of block column c are at positions col_ptr[c] ..
+ * col_ptr[c+1]-1 of col_blk/col_shift, circulants of block row r at
+ * positions row_ptr[r] .. row_ptr[r+1]-1 of row_blk/row_shift, in
+ * increasing order of block, and every array lives in a single memory
+ * block.
+ */
+typedef struct mod2qc
+{
+	int n_rows;		  /* Number of rows in the matrix (mb*z) */
+	int n_cols;		  /* Number of columns, parity part included */
+	int z;			  /* Size of the circulants */
+	int mb;			  /* Number of block rows */
+	int kb;			  /* Number of block columns of the source part */
+	int nnz;		  /* Number of circulants */
+
+	INT32 *col_ptr;		  /* kb+1 offsets in col_blk/col_shift */
+	INT32 *col_blk;		  /* Block row of each circulant */
+	INT32 *col_shift;	  /* Shift of each circulant */
+	INT32 *row_ptr;		  /* mb+1 offsets in row_blk/row_shift */
+	INT32 *row_blk;		  /* Block column of each circulant */
+	INT32 *row_shift;	  /* Shift of each circulant */
+
+	void *mem;		  /* Block holding all the arrays */
+} mod2qc;
+
+/* Largest size of the circulants, and smallest number of block rows:
+   the blocks must be large enough for the description to be compact,
+   and numerous enough for the code to behave like a random one. */
+
+#define Mod2qc_max_z 1024
+#define Mod2qc_min_blocks 16
+
+/* MACROS TO GET AT ELEMENTS OF A QUASI-CYCLIC MATRIX.  For source column
+   j (source column 0 being column n_rows of the matrix), the circulant at
+   position p of its block column j/z has an entry in the row given by
+   mod2qc_col_row(m,p,j%z).  For row i, the circulant at position p of its
+   block row i/z has an entry in the source column given by
+   mod2qc_row_col(m,p,i%z). */
+
+#define mod2qc_col_begin(m,c) ((m)->col_ptr[c])	/* Range of positions */
+#define mod2qc_col_end(m,c) ((m)->col_ptr[(c)+1])	/* of block col c / */
+#define mod2qc_row_begin(m,r) ((m)->row_ptr[r])	/* block row r      */
+#define mod2qc_row_end(m,r) ((m)->row_ptr[(r)+1])
+
+#define mod2qc_col_row(m,p,t) ((m)->col_blk[p]*(m)->z + \
+	((t) - (m)->col_shift[p] + (m)->z) % (m)->z)
+#define mod2qc_row_col(m,p,i) ((m)->row_blk[p]*(m)->z + \
+	((i) + (m)->row_shift[p]) % (m)->z)
+
+/* Weight of row i (staircase included) and of source column j. */
+
+#define mod2qc_row_weight(m,i) (mod2qc_row_end(m,(i)/(m)->z) \
+	- mod2qc_row_begin(m,(i)/(m)->z) + ((i)>=(m)->z ? 2 : 1))
+#define mod2qc_col_weight(m,j) (mod2qc_col_end(m,(j)/(m)->z) \
+	- mod2qc_col_begin(m,(j)/(m)->z))
+
+/* PROCEDURES TO MANIPULATE QUASI-CYCLIC MATRICES. */
+
+int mod2qc_block_size (int, int);
+mod2qc *mod2qc_allocate (int, int, int, int);
+void mod2qc_index_rows (mod2qc *);
+void mod2qc_free (mod2qc *);
+
+#endif // #ifndef LDPC_MATRIX_QC__
@@ -65,6 +65,7 @@
 
 	m->blocks = 0;
 	m->next_free = 0;
+	m->entries = 0;
 
 	for (i = 0; i<n_rows; i++)
 	{ e = &m->rows[i];
@@ -98,6 +99,8 @@
 		m->blocks = b->next;
 		free(b);
 	}
+
+	free(m->entries);
 }
 
 
@@ -126,6 +129,10 @@
 		r->blocks = b->next;
 		free(b);
 	}
+
+	free(r->entries);
+	r->entries = 0;
+	r->next_free = 0;
 }
 
 /* PRINT A SPARSE MOD2 MATRIX IN HUMAN-READABLE FORM. */
@@ -51,6 +51,9 @@ typedef struct mod2sparse
 
 	mod2block *blocks;	  /* Blocks that have been allocated */
 	mod2entry *next_free;	  /* Next free entry */
+
+	mod2entry *entries;	  /* Entries allocated all at once when the
+				     matrix is built in bulk, or 0 */
 } mod2sparse;
 
 /* MACROS TO GET AT ELEMENTS OF A SPARSE MATRIX.  The 'first', 'last', 'next',
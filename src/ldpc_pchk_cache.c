@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ldpc_pchk_cache.h"
+
+static pthread_mutex_t	cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	cache_built = PTHREAD_COND_INITIALIZER;	// a matrix is ready
+static pchk_cache_entry	*cache_head = NULL;	// most recently used
+static pchk_cache_entry	*cache_tail = NULL;	// least recently used
+static int		cache_unused = 0;	// entries with refcount 0
+static char		cache_directory[PCHK_FILE_PATH_MAX] = "";	// matrix files
+
+
+/*
+ * List helpers, called with cache_lock held.
+ */
+	static void
+cache_unlink	(pchk_cache_entry	*entry)
+{
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		cache_head = entry->next;
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else
+		cache_tail = entry->prev;
+	entry->next = entry->prev = NULL;
+}
+
+	static void
+cache_push_front	(pchk_cache_entry	*entry)
+{
+	entry->prev = NULL;
+	entry->next = cache_head;
+	if (cache_head != NULL)
+		cache_head->prev = entry;
+	else
+		cache_tail = entry;
+	cache_head = entry;
+}
+
+	static void
+cache_free_entry	(pchk_cache_entry	*entry)
+{
+	mod2csr_free(entry->matrix);
+	free(entry);
+}
+
+/*
+ * Frees the least recently used unused entries, as long as there are more
+ * than max_unused of them.
+ */
+	static void
+cache_trim	(int	max_unused)
+{
+	pchk_cache_entry	*entry, *prev;
+
+	for (entry = cache_tail; entry != NULL && cache_unused > max_unused; entry = prev) {
+		prev = entry->prev;
+		if (entry->refcount == 0) {
+			cache_unlink(entry);
+			cache_free_entry(entry);
+			cache_unused--;
+		}
+	}
+}
+
+
+/******************************************************************************
+ * pchk_cache_acquire: Returns the (shared) matrix for these parameters.
+ * => See header file for more informations.
+ */
+	pchk_cache_entry*
+pchk_cache_acquire	(int		nbRows,
+			int		nbCols,
+			make_method	makeMethod,
+			int		leftDegree,
+			int		seed,
+			bool		no4cycle,
+			SessionType	type)
+{
+	pchk_cache_entry	*entry;
+	mod2csr			*matrix;
+	ldpc_prng		prng;
+	char			dir[PCHK_FILE_PATH_MAX];
+
+	pthread_mutex_lock(&cache_lock);
+	for (entry = cache_head; entry != NULL; entry = entry->next) {
+		if (entry->nbRows == nbRows && entry->nbCols == nbCols &&
+				entry->makeMethod == makeMethod &&
+				entry->leftDegree == leftDegree &&
+				entry->seed == seed && entry->no4cycle == no4cycle &&
+				entry->type == type) {
+			break;
+		}
+	}
+	if (entry != NULL) {
+		// hit: move it to the front of the list
+		if (entry->refcount++ == 0)
+			cache_unused--;
+		cache_unlink(entry);
+		cache_push_front(entry);
+		// then wait if it is still being built by another thread
+		while (entry->matrix == NULL && !entry->failed)
+			pthread_cond_wait(&cache_built, &cache_lock);
+		if (entry->failed) {
+			if (--entry->refcount == 0)
+				free(entry);
+			entry = NULL;
+		}
+		pthread_mutex_unlock(&cache_lock);
+		return entry;
+	}
+
+	// miss: insert an entry being built, so that other threads needing
+	// the same matrix wait for it instead of building it too. The matrix
+	// is then built without the lock.
+	entry = (pchk_cache_entry*)calloc(1, sizeof(pchk_cache_entry));
+	if (entry == NULL) {
+		pthread_mutex_unlock(&cache_lock);
+		return NULL;
+	}
+	entry->nbRows		= nbRows;
+	entry->nbCols		= nbCols;
+	entry->makeMethod	= makeMethod;
+	entry->leftDegree	= leftDegree;
+	entry->seed		= seed;
+	entry->no4cycle		= no4cycle;
+	entry->type		= type;
+	entry->refcount		= 1;
+	cache_push_front(entry);
+	strcpy(dir, cache_directory);
+	pthread_mutex_unlock(&cache_lock);
+
+	// a matrix generated beforehand is simply mapped from its file
+	matrix = NULL;
+	if (dir[0] != '\0') {
+		matrix = pchk_file_find(dir, nbRows, nbCols, makeMethod, leftDegree, seed, no4cycle, type);
+	}
+	if (matrix == NULL) {
+		if (ldpc_srand(&prng, seed)) {
+			matrix = CreatePchkMatrixCompressed(nbRows, nbCols, makeMethod, leftDegree, &prng, no4cycle, type);
+		} else {
+			fprintf(stderr, "pchk_cache_acquire: ERROR, invalid seed %d\n", seed);
+		}
+	}
+
+	pthread_mutex_lock(&cache_lock);
+	if (matrix != NULL) {
+		entry->matrix = matrix;
+	} else {
+		// remove it, threads waiting for it will give up
+		entry->failed = true;
+		cache_unlink(entry);
+		if (--entry->refcount == 0)
+			free(entry);
+		entry = NULL;
+	}
+	pthread_cond_broadcast(&cache_built);
+	pthread_mutex_unlock(&cache_lock);
+	return entry;
+}
+
+
+/******************************************************************************
+ * pchk_cache_release: Gives back a reference to a cached matrix.
+ * => See header file for more informations.
+ */
+	void
+pchk_cache_release	(pchk_cache_entry	*entry)
+{
+	if (entry == NULL)
+		return;
+	pthread_mutex_lock(&cache_lock);
+	if (--entry->refcount == 0) {
+		cache_unused++;
+		cache_trim(PCHK_CACHE_MAX_UNUSED);
+	}
+	pthread_mutex_unlock(&cache_lock);
+}
+
+
+/******************************************************************************
+ * pchk_cache_purge: Frees all the matrices no longer used.
+ * => See header file for more informations.
+ */
+	void
+pchk_cache_purge	(void)
+{
+	pthread_mutex_lock(&cache_lock);
+	cache_trim(0);
+	pthread_mutex_unlock(&cache_lock);
+}
+
+
+/******************************************************************************
+ * pchk_cache_set_directory: Sets the directory of matrix files.
+ * => See header file for more informations.
+ */
+	int
+pchk_cache_set_directory	(const char	*dir)
+{
+	if (dir != NULL && strlen(dir) >= sizeof(cache_directory))
+		return -1;
+	pthread_mutex_lock(&cache_lock);
+	strcpy(cache_directory, (dir != NULL) ? dir : "");
+	pthread_mutex_unlock(&cache_lock);
+	return 0;
+}
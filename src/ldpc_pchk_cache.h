@@ -0,0 +1,76 @@
+#ifndef LDPC_PCHK_CACHE_H /* { */
+#define LDPC_PCHK_CACHE_H
+
+#include <stdbool.h>
+
+#include "ldpc_create_pchk.h"
+#include "ldpc_matrix_compressed.h"
+#include "ldpc_pchk_file.h"
+
+/**
+ * Process-wide cache of parity check matrices.
+ * A matrix only depends on the parameters given to CreatePchkMatrix, so
+ * all the sessions using the same parameters share one immutable
+ * compressed matrix. Entries are reference counted, and the cache is
+ * protected by a mutex so that sessions can be created and ended from
+ * several threads. Matrices are built without holding the mutex, so that
+ * different matrices can be built in parallel; threads needing a matrix
+ * being built wait for it.
+ * Up to PCHK_CACHE_MAX_UNUSED matrices no longer used by any session are
+ * kept, so that a receiver creating one session per group does not
+ * rebuild the same matrix for each group.
+ * Matrices may also be generated beforehand and saved in a directory of
+ * matrix files (see pchk_cache_set_directory): they are then mapped from
+ * their file instead of being built.
+ */
+#define PCHK_CACHE_MAX_UNUSED	16
+
+typedef struct pchk_cache_entry {
+	struct pchk_cache_entry *next;	// next entry, most recently used first
+	struct pchk_cache_entry *prev;
+
+	// CreatePchkMatrix parameters (the key)
+	int		nbRows;
+	int		nbCols;
+	make_method	makeMethod;
+	int		leftDegree;
+	int		seed;
+	bool		no4cycle;
+	SessionType	type;
+
+	int		refcount;	// number of sessions using it
+	mod2csr*	matrix;		// the matrix, NEVER modified, or NULL
+	// while it is being built
+	bool		failed;		// true if the matrix could not be built
+	// (the entry is then no longer in the cache)
+} pchk_cache_entry;
+
+/**
+ * Returns the matrix for these parameters. If it is not in the cache
+ * yet, it is mapped from its file in the matrix directory if any, built
+ * with CreatePchkMatrixCompressed otherwise. Same parameters as
+ * CreatePchkMatrix.
+ * @return		cache entry, whose reference must be given back
+ *			with pchk_cache_release(), or NULL in case of error.
+ */
+pchk_cache_entry* pchk_cache_acquire (int nbRows, int nbCols, make_method makeMethod, int leftDegree, int seed, bool no4cycle, SessionType type);
+
+/**
+ * Gives back a reference obtained with pchk_cache_acquire().
+ */
+void pchk_cache_release (pchk_cache_entry *entry);
+
+/**
+ * Frees all the matrices that are no longer used by any session.
+ */
+void pchk_cache_purge (void);
+
+/**
+ * Sets the directory of matrix files searched before building a matrix
+ * (see pchk_file_name for the name of the files), or none if dir is NULL
+ * (the default). Matrices already in the cache are not affected.
+ * @return		0 if ok, -1 if the path is too long.
+ */
+int pchk_cache_set_directory (const char *dir);
+
+#endif /* } LDPC_PCHK_CACHE_H */
@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ldpc_pchk_file.h"
+
+
+/*
+ * Size of the arrays of a compressed matrix, in bytes.
+ */
+	static size_t
+arrays_size	(int	nbRows,
+		 int	nbCols,
+		 int	nnz,
+		 int	idxSize)
+{
+	return ((size_t)nbRows + 1 + nbCols + 1) * sizeof(INT32) +
+		2 * (size_t)nnz * idxSize;
+}
+
+	static const char*
+type_name	(SessionType	type)
+{
+	switch (type) {
+	case TypeLDGM:		return "ldgm";
+	case TypeSTAIRS:	return "stairs";
+	case TypeTRIANGLE:	return "triangle";
+	case TypeQCSTAIRS:	return "qcstairs";
+	}
+	return "unknown";
+}
+
+	static const char*
+method_name	(make_method	makeMethod)
+{
+	switch (makeMethod) {
+	case Evencol:		return "evencol";
+	case Evenboth:		return "evenboth";
+	case PEG:		return "peg";
+	}
+	return "unknown";
+}
+
+
+/******************************************************************************
+ * pchk_file_write: Saves a compressed matrix in a file.
+ * => See header file for more informations.
+ */
+	int
+pchk_file_write	(const char	*path,
+		 mod2csr	*matrix,
+		 make_method	makeMethod,
+		 int		leftDegree,
+		 int		seed,
+		 bool		no4cycle,
+		 SessionType	type)
+{
+	pchk_file_header	header;
+	char			tmp[PCHK_FILE_PATH_MAX];
+	FILE			*f;
+	size_t			idxBytes = (size_t)matrix->nnz * matrix->idx_size;
+	bool			ok;
+
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+		fprintf(stderr, "pchk_file_write: ERROR, path too long\n");
+		return -1;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PCHK_FILE_MAGIC, sizeof(header.magic));
+	header.version		= PCHK_FILE_VERSION;
+	header.byteOrder	= PCHK_FILE_BYTE_ORDER;
+	header.nbSourceSymbols	= mod2csr_cols(matrix) - mod2csr_rows(matrix);
+	header.nbSymbols	= mod2csr_cols(matrix);
+	header.makeMethod	= makeMethod;
+	header.leftDegree	= leftDegree;
+	header.seed		= seed;
+	header.no4cycle		= no4cycle;
+	header.type		= type;
+	header.nnz		= matrix->nnz;
+	header.idxSize		= matrix->idx_size;
+
+	if ((f = fopen(tmp, "wb")) == NULL) {
+		fprintf(stderr, "pchk_file_write: ERROR, cannot create %s: %s\n", tmp, strerror(errno));
+		return -1;
+	}
+	ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(matrix->row_ptr, sizeof(INT32), mod2csr_rows(matrix) + 1, f) == (size_t)mod2csr_rows(matrix) + 1 &&
+		fwrite(matrix->col_ptr, sizeof(INT32), mod2csr_cols(matrix) + 1, f) == (size_t)mod2csr_cols(matrix) + 1 &&
+		(idxBytes == 0 || (fwrite(matrix->col_idx, idxBytes, 1, f) == 1 &&
+				   fwrite(matrix->row_idx, idxBytes, 1, f) == 1));
+	if (fclose(f) != 0)
+		ok = false;
+	if (!ok || rename(tmp, path) != 0) {
+		fprintf(stderr, "pchk_file_write: ERROR, cannot write %s: %s\n", path, strerror(errno));
+		unlink(tmp);
+		return -1;
+	}
+	return 0;
+}
+
+
+/******************************************************************************
+ * pchk_file_map: Maps a matrix file read-only.
+ * => See header file for more informations.
+ */
+	mod2csr*
+pchk_file_map	(const char		*path,
+		 pchk_file_header	*header)
+{
+	const pchk_file_header	*h;
+	mod2csr			*m;
+	struct stat		st;
+	void			*map;
+	char			*p;
+	size_t			idxBytes;
+	int			fd;
+	int			nbRows;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return NULL;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(pchk_file_header)) {
+		fprintf(stderr, "pchk_file_map: ERROR, %s is not a matrix file\n", path);
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);	// the mapping remains
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "pchk_file_map: ERROR, cannot map %s: %s\n", path, strerror(errno));
+		return NULL;
+	}
+
+	h = (const pchk_file_header*)map;
+	nbRows = h->nbSymbols - h->nbSourceSymbols;
+	if (memcmp(h->magic, PCHK_FILE_MAGIC, sizeof(h->magic)) != 0 ||
+			h->version != PCHK_FILE_VERSION ||
+			h->byteOrder != PCHK_FILE_BYTE_ORDER ||
+			nbRows <= 0 || h->nbSourceSymbols <= 0 || h->nnz < 0 ||
+			h->idxSize != ((nbRows < 65536 && h->nbSymbols < 65536) ? 2 : 4) ||
+			(size_t)st.st_size != sizeof(pchk_file_header) + arrays_size(nbRows, h->nbSymbols, h->nnz, h->idxSize)) {
+		fprintf(stderr, "pchk_file_map: ERROR, %s is not a valid matrix file (version %u expected)\n",
+				path, PCHK_FILE_VERSION);
+		munmap(map, st.st_size);
+		return NULL;
+	}
+	if ((m = (mod2csr*)calloc(1, sizeof(mod2csr))) == NULL) {
+		munmap(map, st.st_size);
+		return NULL;
+	}
+	m->n_rows	= nbRows;
+	m->n_cols	= h->nbSymbols;
+	m->nnz		= h->nnz;
+	m->idx_size	= h->idxSize;
+	p = (char*)map + sizeof(pchk_file_header);
+	m->row_ptr	= (INT32*)p;
+	m->col_ptr	= m->row_ptr + m->n_rows + 1;
+	p = (char*)(m->col_ptr + m->n_cols + 1);
+	idxBytes	= (size_t)m->nnz * m->idx_size;
+	m->col_idx	= p;
+	m->row_idx	= p + idxBytes;
+	m->mem		= map;
+	m->mapped	= st.st_size;
+	if (m->row_ptr[m->n_rows] != m->nnz || m->col_ptr[m->n_cols] != m->nnz) {
+		fprintf(stderr, "pchk_file_map: ERROR, %s is corrupted\n", path);
+		mod2csr_free(m);
+		return NULL;
+	}
+	if (header != NULL)
+		*header = *h;
+	return m;
+}
+
+
+/******************************************************************************
+ * pchk_file_name: Name of the file of a matrix.
+ * => See header file for more informations.
+ */
+	int
+pchk_file_name	(char		*name,
+		 int		size,
+		 const char	*dir,
+		 int		nbRows,
+		 int		nbCols,
+		 make_method	makeMethod,
+		 int		leftDegree,
+		 int		seed,
+		 bool		no4cycle,
+		 SessionType	type)
+{
+	int	len;
+
+	len = snprintf(name, size, "%s/ldpc_%s_k%d_n%d_d%d_s%d_%s%s.pchk", dir,
+			type_name(type), nbCols - nbRows, nbCols, leftDegree, seed,
+			method_name(makeMethod), no4cycle ? "_no4cycle" : "");
+	return (len < 0 || len >= size) ? -1 : 0;
+}
+
+
+/******************************************************************************
+ * pchk_file_find: Maps the file of a matrix from a directory.
+ * => See header file for more informations.
+ */
+	mod2csr*
+pchk_file_find	(const char	*dir,
+		 int		nbRows,
+		 int		nbCols,
+		 make_method	makeMethod,
+		 int		leftDegree,
+		 int		seed,
+		 bool		no4cycle,
+		 SessionType	type)
+{
+	pchk_file_header	h;
+	char			path[PCHK_FILE_PATH_MAX];
+	mod2csr			*m;
+
+	if (pchk_file_name(path, sizeof(path), dir, nbRows, nbCols, makeMethod, leftDegree, seed, no4cycle, type) < 0)
+		return NULL;
+	if ((m = pchk_file_map(path, &h)) == NULL)
+		return NULL;
+	if (h.nbSymbols != nbCols || h.nbSymbols - h.nbSourceSymbols != nbRows ||
+			h.makeMethod != (INT32)makeMethod || h.leftDegree != leftDegree ||
+			h.seed != seed || h.no4cycle != (INT32)no4cycle || h.type != (INT32)type) {
+		fprintf(stderr, "pchk_file_find: ERROR, %s holds another matrix, ignored\n", path);
+		mod2csr_free(m);
+		return NULL;
+	}
+	return m;
+}
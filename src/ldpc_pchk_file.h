@@ -0,0 +1,85 @@
+#ifndef LDPC_PCHK_FILE_H /* { */
+#define LDPC_PCHK_FILE_H
+
+#include <stdbool.h>
+
+#include "ldpc_types.h"
+#include "ldpc_create_pchk.h"
+#include "ldpc_matrix_compressed.h"
+
+/**
+ * Parity check matrix files.
+ * A matrix can be generated once (e.g. offline, see the ldpc_mkpchk demo)
+ * and saved in its compressed form, then mapped read-only in memory by
+ * all the processes using it: the pages are shared through the system
+ * page cache, and loading the matrix costs a single mmap.
+ * A file is made of a fixed size header, followed by the arrays of the
+ * compressed matrix exactly as they are laid out in memory (see
+ * mod2csr): row_ptr, col_ptr, col_idx then row_idx. Integers are stored
+ * in the byte order of the host that wrote the file, which is checked
+ * when it is mapped.
+ * A sparse matrix is saved through its compressed form (see
+ * mod2csr_from_sparse and mod2sparse_from_csr).
+ */
+#define PCHK_FILE_MAGIC		"LDPCPCHK"
+#define PCHK_FILE_VERSION	1
+#define PCHK_FILE_BYTE_ORDER	0x01020304
+
+/* Maximum length of a file path, directory included. */
+#define PCHK_FILE_PATH_MAX	1024
+
+typedef struct {
+	char	magic[8];	// PCHK_FILE_MAGIC, not nul-terminated
+	UINT32	version;	// PCHK_FILE_VERSION
+	UINT32	byteOrder;	// PCHK_FILE_BYTE_ORDER
+	// CreatePchkMatrix parameters
+	INT32	nbSourceSymbols;	// k
+	INT32	nbSymbols;	// n, i.e. the number of columns (n-k rows)
+	INT32	makeMethod;
+	INT32	leftDegree;
+	INT32	seed;
+	INT32	no4cycle;
+	INT32	type;		// SessionType
+	// compressed matrix
+	INT32	nnz;
+	INT32	idxSize;	// 2 or 4
+	INT32	reserved[3];	// 0
+} pchk_file_header;
+
+/**
+ * Saves a compressed matrix, built with these parameters, in a file.
+ * The file is written under a temporary name then renamed, so that
+ * processes mapping it never see a partial file.
+ * @return		0 if ok, -1 in case of error.
+ */
+int pchk_file_write (const char *path, mod2csr *matrix, make_method makeMethod, int leftDegree, int seed, bool no4cycle, SessionType type);
+
+/**
+ * Maps a matrix file read-only.
+ * The header and the size of the file are checked, not the content of
+ * the arrays: matrix files must come from a trusted source.
+ * @param header	(OUT) header of the file, or NULL.
+ * @return		the matrix (to be freed with mod2csr_free, which
+ *			unmaps the file), or NULL in case of error.
+ */
+mod2csr* pchk_file_map (const char *path, pchk_file_header *header);
+
+/**
+ * Name of the file of a matrix in a directory of matrix files, e.g.
+ * "<dir>/ldpc_stairs_k1000_n1500_d3_s2003_evenboth.pchk", with a
+ * "_no4cycle" suffix for the matrices without 4-cycles. Same parameters
+ * as CreatePchkMatrix.
+ * @return		0 if ok, -1 if the name does not fit in size bytes.
+ */
+int pchk_file_name (char *name, int size, const char *dir, int nbRows, int nbCols, make_method makeMethod, int leftDegree, int seed, bool no4cycle, SessionType type);
+
+/**
+ * Maps the file of a matrix from a directory of matrix files, if any.
+ * Same parameters as CreatePchkMatrix.
+ * @return		the matrix, or NULL if there is no such file or it
+ *			does not hold this matrix (a message is then
+ *			printed).
+ */
+mod2csr* pchk_file_find (const char *dir, int nbRows, int nbCols, make_method makeMethod, int leftDegree, int seed, bool no4cycle, SessionType type);
+
+#endif /* } LDPC_PCHK_FILE_H */
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ldpc_symbol_pool.h"
+
+/* Size of the slab header, rounded so that the first buffer is aligned. */
+#define SLAB_HEADER	((sizeof(symbol_pool_slab) + SYMBOL_POOL_ALIGN - 1) & ~(size_t)(SYMBOL_POOL_ALIGN - 1))
+
+
+/******************************************************************************
+ * symbol_pool_create: Creates a symbol pool.
+ * => See header file for more informations.
+ */
+	symbol_pool*
+symbol_pool_create	(size_t	symbolSize,
+			int	symbolsPerSlab,
+			bool	locked)
+{
+	symbol_pool	*pool;
+
+	if ((pool = (symbol_pool*)calloc(1, sizeof(symbol_pool))) == NULL)
+		return NULL;
+	pool->symbolSize = symbolSize;
+	// a free buffer holds the free list link
+	pool->stride = (symbolSize < sizeof(void*)) ? sizeof(void*) : symbolSize;
+	pool->stride = (pool->stride + SYMBOL_POOL_ALIGN - 1) & ~(size_t)(SYMBOL_POOL_ALIGN - 1);
+	pool->symbolsPerSlab = (symbolsPerSlab > 0) ? symbolsPerSlab : SYMBOL_POOL_SLAB;
+	pool->locked = locked;
+	if (locked && pthread_mutex_init(&pool->lock, NULL) != 0) {
+		free(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+
+/******************************************************************************
+ * symbol_pool_destroy: Releases all the memory of a pool.
+ * => See header file for more informations.
+ */
+	void
+symbol_pool_destroy	(symbol_pool	*pool)
+{
+	symbol_pool_slab	*slab;
+
+	if (pool == NULL)
+		return;
+	while ((slab = pool->slabs) != NULL) {
+		pool->slabs = slab->next;
+		free(slab);
+	}
+	if (pool->locked)
+		pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
+
+
+/*
+ * Allocates a new slab and puts all its buffers in the free list.
+ * Called with the lock held.
+ */
+	static bool
+pool_grow	(symbol_pool	*pool)
+{
+	symbol_pool_slab	*slab;
+	char			*buf;
+	int			i;
+
+	if (posix_memalign((void**)&slab, SYMBOL_POOL_ALIGN,
+				SLAB_HEADER + pool->stride * pool->symbolsPerSlab) != 0) {
+		return false;
+	}
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	pool->nbSlabs++;
+	// link the buffers, first one at the head of the free list
+	buf = (char*)slab + SLAB_HEADER + pool->stride * (pool->symbolsPerSlab - 1);
+	for (i = 0; i < pool->symbolsPerSlab; i++, buf -= pool->stride) {
+		*(void**)buf = pool->freeList;
+		pool->freeList = buf;
+	}
+	return true;
+}
+
+
+/******************************************************************************
+ * symbol_pool_get: Gets a buffer from the pool.
+ * => See header file for more informations.
+ */
+	void*
+symbol_pool_get	(symbol_pool	*pool)
+{
+	void	*symbol = NULL;
+
+	if (pool->locked)
+		pthread_mutex_lock(&pool->lock);
+	if (pool->freeList != NULL || pool_grow(pool)) {
+		symbol = pool->freeList;
+		pool->freeList = *(void**)symbol;
+		pool->nbUsed++;
+	}
+	if (pool->locked)
+		pthread_mutex_unlock(&pool->lock);
+	return symbol;
+}
+
+
+/******************************************************************************
+ * symbol_pool_put: Gives a buffer back to the pool.
+ * => See header file for more informations.
+ */
+	void
+symbol_pool_put	(symbol_pool	*pool,
+		void		*symbol)
+{
+	if (symbol == NULL)
+		return;
+	if (pool->locked)
+		pthread_mutex_lock(&pool->lock);
+	*(void**)symbol = pool->freeList;
+	pool->freeList = symbol;
+	pool->nbUsed--;
+	if (pool->locked)
+		pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,66 @@
+#ifndef LDPC_SYMBOL_POOL_H /* { */
+#define LDPC_SYMBOL_POOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Pool of fixed size symbol buffers.
+ * Buffers are carved out of slabs of SYMBOL_POOL_SLAB buffers (or any
+ * number given at creation), each buffer being aligned on
+ * SYMBOL_POOL_ALIGN bytes. Freed buffers go back to a free list, so that
+ * getting or putting a buffer is O(1), and slabs are only returned to the
+ * system all at once, by symbol_pool_destroy().
+ * A pool is either private to a session, or shared by several sessions
+ * (possibly running in different threads, in which case it must be
+ * created with locking enabled).
+ */
+#define SYMBOL_POOL_SLAB	64
+#define SYMBOL_POOL_ALIGN	64
+
+typedef struct symbol_pool_slab {
+	struct symbol_pool_slab *next;	// next slab allocated
+} symbol_pool_slab;
+
+typedef struct {
+	size_t		symbolSize;	// usable size of a buffer, in bytes
+	size_t		stride;		// distance between two buffers
+	int		symbolsPerSlab;
+	void*		freeList;	// free buffers, linked through their
+	// first bytes
+	symbol_pool_slab* slabs;	// slabs allocated so far
+	int		nbSlabs;
+	int		nbUsed;		// buffers currently given out
+	bool		locked;		// true if the pool is protected by lock
+	pthread_mutex_t	lock;
+} symbol_pool;
+
+/**
+ * Creates a symbol pool.
+ * @param symbolSize	(IN) size of the buffers, in bytes.
+ * @param symbolsPerSlab (IN) number of buffers allocated at once, or 0 for
+ *			the default (SYMBOL_POOL_SLAB).
+ * @param locked	(IN) true if the pool may be used by several threads.
+ * @return		the pool, or NULL in case of error.
+ */
+symbol_pool* symbol_pool_create (size_t symbolSize, int symbolsPerSlab, bool locked);
+
+/**
+ * Releases all the memory of a pool, including all the buffers still in
+ * use, in a single call.
+ */
+void symbol_pool_destroy (symbol_pool *pool);
+
+/**
+ * Gets a buffer from the pool. Its content is undefined.
+ * @return		the buffer, or NULL if no memory is left.
+ */
+void* symbol_pool_get (symbol_pool *pool);
+
+/**
+ * Gives a buffer obtained with symbol_pool_get back to the pool.
+ */
+void symbol_pool_put (symbol_pool *pool, void *symbol);
+
+#endif /* } LDPC_SYMBOL_POOL_H */
@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "ldpc_types.h"
+#include "ldpc_xor.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LDPC_XOR_X86
+#include <immintrin.h>
+#endif
+
+static void xor_resolve (void *to, const void *from, size_t len);
+
+/* Starts with the resolver, so that a call made before the constructor
+   below (e.g. from another constructor) still works. */
+ldpc_xor_func		ldpc_xor_impl = xor_resolve;
+static ldpc_xor_kernel	current_kernel = LDPC_XOR_AUTO;
+
+
+/******************************************************************************
+ * Portable kernel: 64-bit words, with a byte loop for the unaligned head
+ * (until the destination is aligned) and for the tail.
+ * The source is read with memcpy since it may not be aligned like the
+ * destination, the compiler turns it into a plain load.
+ */
+	static void
+xor_generic	(void	*to,
+		const void	*from,
+		size_t	len)
+{
+	UINT8		*t = (UINT8*)to;
+	const UINT8	*f = (const UINT8*)from;
+	UINT64		w;
+
+	for (; len > 0 && ((uintptr_t)t & 7) != 0; len--) {
+		*t++ ^= *f++;
+	}
+	for (; len >= 32; len -= 32, t += 32, f += 32) {
+		memcpy(&w, f, 8);	((UINT64*)t)[0] ^= w;
+		memcpy(&w, f + 8, 8);	((UINT64*)t)[1] ^= w;
+		memcpy(&w, f + 16, 8);	((UINT64*)t)[2] ^= w;
+		memcpy(&w, f + 24, 8);	((UINT64*)t)[3] ^= w;
+	}
+	for (; len >= 8; len -= 8, t += 8, f += 8) {
+		memcpy(&w, f, 8);
+		*(UINT64*)t ^= w;
+	}
+	for (; len > 0; len--) {
+		*t++ ^= *f++;
+	}
+}
+
+#ifdef LDPC_XOR_X86
+
+/*
+ * SIMD kernels. Each one aligns the destination on the vector size with
+ * the byte loop, processes 4 vectors per iteration (unaligned loads from
+ * the source, aligned load/store on the destination), and leaves the
+ * remaining bytes to the generic kernel.
+ * They are compiled with a target attribute so that the library does not
+ * need any -m flag, and are only called if CPUID says so.
+ */
+__attribute__((target("sse2")))
+	static void
+xor_sse2	(void	*to,
+		const void	*from,
+		size_t	len)
+{
+	UINT8		*t = (UINT8*)to;
+	const UINT8	*f = (const UINT8*)from;
+
+	for (; len > 0 && ((uintptr_t)t & 15) != 0; len--) {
+		*t++ ^= *f++;
+	}
+	for (; len >= 64; len -= 64, t += 64, f += 64) {
+		__m128i	a0 = _mm_loadu_si128((const __m128i*)f);
+		__m128i	a1 = _mm_loadu_si128((const __m128i*)(f + 16));
+		__m128i	a2 = _mm_loadu_si128((const __m128i*)(f + 32));
+		__m128i	a3 = _mm_loadu_si128((const __m128i*)(f + 48));
+		_mm_store_si128((__m128i*)t, _mm_xor_si128(a0, _mm_load_si128((__m128i*)t)));
+		_mm_store_si128((__m128i*)(t + 16), _mm_xor_si128(a1, _mm_load_si128((__m128i*)(t + 16))));
+		_mm_store_si128((__m128i*)(t + 32), _mm_xor_si128(a2, _mm_load_si128((__m128i*)(t + 32))));
+		_mm_store_si128((__m128i*)(t + 48), _mm_xor_si128(a3, _mm_load_si128((__m128i*)(t + 48))));
+	}
+	for (; len >= 16; len -= 16, t += 16, f += 16) {
+		_mm_store_si128((__m128i*)t, _mm_xor_si128(_mm_loadu_si128((const __m128i*)f),
+					_mm_load_si128((__m128i*)t)));
+	}
+	xor_generic(t, f, len);
+}
+
+__attribute__((target("avx2")))
+	static void
+xor_avx2	(void	*to,
+		const void	*from,
+		size_t	len)
+{
+	UINT8		*t = (UINT8*)to;
+	const UINT8	*f = (const UINT8*)from;
+
+	for (; len > 0 && ((uintptr_t)t & 31) != 0; len--) {
+		*t++ ^= *f++;
+	}
+	for (; len >= 128; len -= 128, t += 128, f += 128) {
+		__m256i	a0 = _mm256_loadu_si256((const __m256i*)f);
+		__m256i	a1 = _mm256_loadu_si256((const __m256i*)(f + 32));
+		__m256i	a2 = _mm256_loadu_si256((const __m256i*)(f + 64));
+		__m256i	a3 = _mm256_loadu_si256((const __m256i*)(f + 96));
+		_mm256_store_si256((__m256i*)t, _mm256_xor_si256(a0, _mm256_load_si256((__m256i*)t)));
+		_mm256_store_si256((__m256i*)(t + 32), _mm256_xor_si256(a1, _mm256_load_si256((__m256i*)(t + 32))));
+		_mm256_store_si256((__m256i*)(t + 64), _mm256_xor_si256(a2, _mm256_load_si256((__m256i*)(t + 64))));
+		_mm256_store_si256((__m256i*)(t + 96), _mm256_xor_si256(a3, _mm256_load_si256((__m256i*)(t + 96))));
+	}
+	for (; len >= 32; len -= 32, t += 32, f += 32) {
+		_mm256_store_si256((__m256i*)t, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)f),
+					_mm256_load_si256((__m256i*)t)));
+	}
+	xor_generic(t, f, len);
+}
+
+__attribute__((target("avx512f")))
+	static void
+xor_avx512	(void	*to,
+		const void	*from,
+		size_t	len)
+{
+	UINT8		*t = (UINT8*)to;
+	const UINT8	*f = (const UINT8*)from;
+
+	for (; len > 0 && ((uintptr_t)t & 63) != 0; len--) {
+		*t++ ^= *f++;
+	}
+	for (; len >= 256; len -= 256, t += 256, f += 256) {
+		__m512i	a0 = _mm512_loadu_si512((const void*)f);
+		__m512i	a1 = _mm512_loadu_si512((const void*)(f + 64));
+		__m512i	a2 = _mm512_loadu_si512((const void*)(f + 128));
+		__m512i	a3 = _mm512_loadu_si512((const void*)(f + 192));
+		_mm512_store_si512((void*)t, _mm512_xor_si512(a0, _mm512_load_si512((void*)t)));
+		_mm512_store_si512((void*)(t + 64), _mm512_xor_si512(a1, _mm512_load_si512((void*)(t + 64))));
+		_mm512_store_si512((void*)(t + 128), _mm512_xor_si512(a2, _mm512_load_si512((void*)(t + 128))));
+		_mm512_store_si512((void*)(t + 192), _mm512_xor_si512(a3, _mm512_load_si512((void*)(t + 192))));
+	}
+	for (; len >= 64; len -= 64, t += 64, f += 64) {
+		_mm512_store_si512((void*)t, _mm512_xor_si512(_mm512_loadu_si512((const void*)f),
+					_mm512_load_si512((void*)t)));
+	}
+	xor_generic(t, f, len);
+}
+
+#endif /* LDPC_XOR_X86 */
+
+
+/******************************************************************************
+ * CPU feature detection.
+ */
+	static bool
+cpu_supports	(ldpc_xor_kernel	kernel)
+{
+	switch (kernel) {
+	case LDPC_XOR_GENERIC:
+		return true;
+#ifdef LDPC_XOR_X86
+	case LDPC_XOR_SSE2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2");
+	case LDPC_XOR_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	case LDPC_XOR_AVX512:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f");
+#endif
+	default:
+		return false;
+	}
+}
+
+	static ldpc_xor_func
+kernel_func	(ldpc_xor_kernel	kernel)
+{
+	switch (kernel) {
+#ifdef LDPC_XOR_X86
+	case LDPC_XOR_SSE2:	return xor_sse2;
+	case LDPC_XOR_AVX2:	return xor_avx2;
+	case LDPC_XOR_AVX512:	return xor_avx512;
+#endif
+	default:		return xor_generic;
+	}
+}
+
+	static ldpc_xor_kernel
+best_kernel	(void)
+{
+	if (cpu_supports(LDPC_XOR_AVX512))
+		return LDPC_XOR_AVX512;
+	if (cpu_supports(LDPC_XOR_AVX2))
+		return LDPC_XOR_AVX2;
+	if (cpu_supports(LDPC_XOR_SSE2))
+		return LDPC_XOR_SSE2;
+	return LDPC_XOR_GENERIC;
+}
+
+
+/******************************************************************************
+ * ldpc_xor_init: Selects the best kernel for this CPU.
+ * => See header file for more informations.
+ */
+__attribute__((constructor))
+	void
+ldpc_xor_init	(void)
+{
+	const char	*env = getenv("LDPC_XOR_KERNEL");
+	int		k;
+
+	if (env != NULL) {
+		for (k = LDPC_XOR_GENERIC; k <= LDPC_XOR_AVX512; k++) {
+			if (strcmp(env, ldpc_xor_kernel_name((ldpc_xor_kernel)k)) == 0 &&
+					ldpc_xor_select((ldpc_xor_kernel)k)) {
+				return;
+			}
+		}
+	}
+	ldpc_xor_select(LDPC_XOR_AUTO);
+}
+
+	static void
+xor_resolve	(void	*to,
+		const void	*from,
+		size_t	len)
+{
+	ldpc_xor_init();
+	ldpc_xor_impl(to, from, len);
+}
+
+
+/******************************************************************************
+ * ldpc_xor_select: Forces a given kernel.
+ * => See header file for more informations.
+ */
+	bool
+ldpc_xor_select	(ldpc_xor_kernel	kernel)
+{
+	if (kernel == LDPC_XOR_AUTO) {
+		kernel = best_kernel();
+	} else if (!cpu_supports(kernel)) {
+		return false;
+	}
+	current_kernel = kernel;
+	ldpc_xor_impl = kernel_func(kernel);
+	return true;
+}
+
+	ldpc_xor_kernel
+ldpc_xor_current	(void)
+{
+	return current_kernel;
+}
+
+	const char*
+ldpc_xor_kernel_name	(ldpc_xor_kernel	kernel)
+{
+	switch (kernel) {
+	case LDPC_XOR_GENERIC:	return "generic";
+	case LDPC_XOR_SSE2:	return "sse2";
+	case LDPC_XOR_AVX2:	return "avx2";
+	case LDPC_XOR_AVX512:	return "avx512";
+	default:		return "auto";
+	}
+}
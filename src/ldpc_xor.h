@@ -0,0 +1,71 @@
+#ifndef LDPC_XOR_H /* { */
+#define LDPC_XOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/****** CONSTANT AND CLASS DEFINITION *****************************************/
+
+/**
+ * Symbol XOR kernels. The best one supported by the CPU is selected
+ * at startup (CPUID), but a specific one can be forced, either with
+ * ldpc_xor_select() or with the LDPC_XOR_KERNEL environment variable
+ * (generic, sse2, avx2 or avx512).
+ */
+typedef enum {
+	LDPC_XOR_AUTO = 0,	// best kernel supported by the CPU
+	LDPC_XOR_GENERIC,	// portable 64-bit word kernel
+	LDPC_XOR_SSE2,
+	LDPC_XOR_AVX2,
+	LDPC_XOR_AVX512
+} ldpc_xor_kernel;
+
+typedef void (*ldpc_xor_func) (void *to, const void *from, size_t len);
+
+/**
+ * Kernel currently in use. Do not call directly, use ldpc_xor().
+ */
+extern ldpc_xor_func	ldpc_xor_impl;
+
+/**
+ * ldpc_xor_init: Selects the best kernel for this CPU. This is done
+ * automatically at startup, calling it again is harmless.
+ */
+void ldpc_xor_init (void);
+
+/**
+ * Forces a given kernel.
+ * This changes a process-wide setting: it must not be called while other
+ * threads may be using the codec.
+ * @param kernel	(IN) kernel to use, LDPC_XOR_AUTO to use the best one.
+ * @return		true if the kernel is supported by this CPU and has
+ *			been selected, false otherwise (nothing is changed).
+ */
+bool ldpc_xor_select (ldpc_xor_kernel kernel);
+
+/**
+ * Returns the kernel currently in use.
+ */
+ldpc_xor_kernel ldpc_xor_current (void);
+
+/**
+ * Returns the printable name of a kernel ("generic", "sse2", ...).
+ */
+const char* ldpc_xor_kernel_name (ldpc_xor_kernel kernel);
+
+/**
+ * Calculates to = to ^ from over len bytes. Both buffers can have any
+ * alignment, but must not overlap.
+ * @param to		(IN/OUT) destination buffer
+ * @param from		(IN) buffer added to the destination
+ * @param len		(IN) number of bytes
+ */
+	static inline void
+ldpc_xor	(void	*to,
+		const void	*from,
+		size_t	len)
+{
+	ldpc_xor_impl(to, from, len);
+}
+
+#endif /* } LDPC_XOR_H */
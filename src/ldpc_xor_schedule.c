@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ldpc_xor_schedule.h"
+
+
+/*
+ * Working state of xor_schedule_build: the operands of each row, kept
+ * sorted, and the rows of each operand, rebuilt at each step.
+ */
+typedef struct {
+	int	nbOps;		// operands so far (symbols and temporaries)
+	int	maxOps;
+	int	*rowPtr;	// start of each row in rowOps
+	int	*rowLen;	// current length of each row
+	int	*rowOps;
+	int	*opPtr;		// maxOps+1 offsets in opRows
+	int	*opRows;	// rows of each operand
+	int	*count;		// pairs (a, b) for the current a, by b
+	int	*touched;	// b whose count is not zero
+} schedule_work;
+
+
+/*
+ * Rows of each operand, by counting sort, in increasing order.
+ */
+	static void
+index_operands	(schedule_work	*w,
+		 int		nbRows)
+{
+	int	r, p, a;
+
+	memset(w->opPtr, 0, (w->nbOps + 1) * sizeof(int));
+	for (r = 0; r < nbRows; r++) {
+		for (p = w->rowPtr[r]; p < w->rowPtr[r] + w->rowLen[r]; p++)
+			w->opPtr[w->rowOps[p] + 1]++;
+	}
+	for (a = 0; a < w->nbOps; a++)
+		w->opPtr[a + 1] += w->opPtr[a];
+	for (r = 0; r < nbRows; r++) {
+		for (p = w->rowPtr[r]; p < w->rowPtr[r] + w->rowLen[r]; p++)
+			w->opRows[w->opPtr[w->rowOps[p]]++] = r;
+	}
+	for (a = w->nbOps; a > 0; a--)
+		w->opPtr[a] = w->opPtr[a - 1];
+	w->opPtr[0] = 0;
+}
+
+/*
+ * Most frequent pair of operands (a < b), the first one found in case of
+ * tie. Returns its number of rows.
+ */
+	static int
+best_pair	(schedule_work	*w,
+		 int		*bestA,
+		 int		*bestB)
+{
+	int	a, b, q, p, r, nbTouched, best = 0;
+
+	for (a = 0; a < w->nbOps; a++) {
+		if (w->opPtr[a + 1] - w->opPtr[a] <= best)
+			continue;	// cannot do better
+		nbTouched = 0;
+		for (q = w->opPtr[a]; q < w->opPtr[a + 1]; q++) {
+			r = w->opRows[q];
+			// rows are sorted: b > a follow a
+			for (p = w->rowPtr[r] + w->rowLen[r] - 1; p >= w->rowPtr[r] && (b = w->rowOps[p]) > a; p--) {
+				if (w->count[b]++ == 0)
+					w->touched[nbTouched++] = b;
+			}
+		}
+		for (q = 0; q < nbTouched; q++) {
+			b = w->touched[q];
+			if (w->count[b] > best || (w->count[b] == best && a == *bestA && b < *bestB)) {
+				best = w->count[b];
+				*bestA = a;
+				*bestB = b;
+			}
+			w->count[b] = 0;
+		}
+	}
+	return best;
+}
+
+/*
+ * Replaces the pair (a, b) with operand t in all the rows holding both.
+ * t being the largest operand, appending it keeps the rows sorted.
+ */
+	static void
+replace_pair	(schedule_work	*w,
+		 int		a,
+		 int		b,
+		 int		t)
+{
+	int	q, r, p, l, op, found;
+
+	for (q = w->opPtr[a]; q < w->opPtr[a + 1]; q++) {
+		r = w->opRows[q];
+		found = 0;
+		for (p = w->rowPtr[r]; p < w->rowPtr[r] + w->rowLen[r]; p++)
+			found += (w->rowOps[p] == b);
+		if (!found)
+			continue;
+		for (p = l = w->rowPtr[r]; p < w->rowPtr[r] + w->rowLen[r]; p++) {
+			op = w->rowOps[p];
+			if (op != a && op != b)
+				w->rowOps[l++] = op;
+		}
+		w->rowOps[l++] = t;
+		w->rowLen[r] = l - w->rowPtr[r];
+	}
+}
+
+
+/******************************************************************************
+ * xor_schedule_build: Builds the schedule of an encoder.
+ * => See header file for more informations.
+ */
+	xor_schedule*
+xor_schedule_build	(mod2csr	*matrix,
+			 int		nbSourceSymbols)
+{
+	xor_schedule	*s;
+	schedule_work	w;
+	int	nbRows = mod2csr_rows(matrix);
+	int	nbSymbols = mod2csr_cols(matrix);
+	int	maxTemps, nnz, r, p, q, col, op, a, b, t;
+
+	memset(&w, 0, sizeof(w));
+	// every temporary saves at least one XOR sum
+	maxTemps = matrix->nnz;
+	w.nbOps = nbSymbols;
+	w.maxOps = nbSymbols + maxTemps;
+	s = (xor_schedule*)calloc(1, sizeof(xor_schedule));
+	w.rowPtr = (int*)malloc((nbRows + 1) * sizeof(int));
+	w.rowLen = (int*)malloc((nbRows + 1) * sizeof(int));
+	w.rowOps = (int*)malloc((matrix->nnz + 1) * sizeof(int));
+	w.opPtr = (int*)malloc((w.maxOps + 1) * sizeof(int));
+	w.opRows = (int*)malloc((matrix->nnz + 1) * sizeof(int));
+	w.count = (int*)calloc(w.maxOps, sizeof(int));
+	w.touched = (int*)malloc(w.maxOps * sizeof(int));
+	if (s == NULL || w.rowPtr == NULL || w.rowLen == NULL || w.rowOps == NULL ||
+			w.opPtr == NULL || w.opRows == NULL || w.count == NULL || w.touched == NULL ||
+			(s->temp_ops = (INT32*)malloc((2 * maxTemps + 1) * sizeof(INT32))) == NULL) {
+		goto error;
+	}
+	s->nb_symbols = nbSymbols;
+	s->nb_rows = nbRows;
+
+	// rows of the matrix as sorted lists of symbols, the parity symbol
+	// of the row excepted (parity columns come first in the matrix, see
+	// GetSymbolSeqno)
+	nnz = 0;
+	for (r = 0; r < nbRows; r++) {
+		w.rowPtr[r] = nnz;
+		for (p = mod2csr_row_begin(matrix, r); p < mod2csr_row_end(matrix, r); p++) {
+			col = mod2csr_col(matrix, p);
+			if (col == r)
+				continue;
+			op = (col < nbRows) ? nbSourceSymbols + col : col - nbRows;
+			for (q = nnz; q > w.rowPtr[r] && w.rowOps[q - 1] > op; q--)
+				w.rowOps[q] = w.rowOps[q - 1];
+			w.rowOps[q] = op;
+			nnz++;
+		}
+		w.rowLen[r] = nnz - w.rowPtr[r];
+		if (w.rowLen[r] > 1)
+			s->naive_xors += w.rowLen[r] - 1;
+	}
+	w.rowPtr[nbRows] = nnz;
+
+	// then the most frequent pair becomes a temporary, as long as one is
+	// shared by several rows
+	for (;;) {
+		index_operands(&w, nbRows);
+		a = b = -1;
+		if (best_pair(&w, &a, &b) < 2)
+			break;
+		t = s->nb_temps++;
+		s->temp_ops[2 * t] = a;
+		s->temp_ops[2 * t + 1] = b;
+		replace_pair(&w, a, b, w.nbOps++);
+	}
+
+	// compacted rows
+	if ((s->row_ptr = (INT32*)malloc((nbRows + 1) * sizeof(INT32))) == NULL ||
+			(s->row_ops = (INT32*)malloc((nnz + 1) * sizeof(INT32))) == NULL) {
+		goto error;
+	}
+	s->xors = s->nb_temps;
+	for (r = 0, q = 0; r < nbRows; r++) {
+		s->row_ptr[r] = q;
+		for (p = w.rowPtr[r]; p < w.rowPtr[r] + w.rowLen[r]; p++)
+			s->row_ops[q++] = w.rowOps[p];
+		if (w.rowLen[r] > 1)
+			s->xors += w.rowLen[r] - 1;
+	}
+	s->row_ptr[nbRows] = q;
+
+	free(w.rowPtr);
+	free(w.rowLen);
+	free(w.rowOps);
+	free(w.opPtr);
+	free(w.opRows);
+	free(w.count);
+	free(w.touched);
+	return s;
+
+error:
+	fprintf(stderr, "xor_schedule_build: ERROR, out of memory\n");
+	free(w.rowPtr);
+	free(w.rowLen);
+	free(w.rowOps);
+	free(w.opPtr);
+	free(w.opRows);
+	free(w.count);
+	free(w.touched);
+	xor_schedule_free(s);
+	return NULL;
+}
+
+
+/******************************************************************************
+ * xor_schedule_free: Frees a schedule.
+ * => See header file for more informations.
+ */
+	void
+xor_schedule_free	(xor_schedule	*schedule)
+{
+	if (schedule == NULL)
+		return;
+	free(schedule->temp_ops);
+	free(schedule->row_ptr);
+	free(schedule->row_ops);
+	free(schedule);
+}
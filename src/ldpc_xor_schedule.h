@@ -0,0 +1,55 @@
+#ifndef LDPC_XOR_SCHEDULE_H /* { */
+#define LDPC_XOR_SCHEDULE_H
+
+#include "ldpc_types.h"
+#include "ldpc_matrix_compressed.h"
+
+/**
+ * XOR schedule of an encoder.
+ * Each parity symbol is the XOR sum of the symbols of its row (its own
+ * parity symbol excepted). Rows often share pairs of symbols: each pair
+ * shared by several rows is computed once as a temporary, which replaces
+ * the pair in these rows. Temporaries may themselves be paired, and the
+ * most frequent pair is always taken first (greedy common subexpression
+ * elimination, as in Paar's algorithm).
+ * Operands are numbered as follows: symbol seqno (in {0.. n-1} range,
+ * source symbols first) is operand seqno, temporary t is operand n+t.
+ * The operands of a temporary are always lower than the temporary itself,
+ * and those of a row only involve parity symbols of lower rows, so that
+ * computing the temporaries in increasing order, each one just before
+ * the first row needing it, and the rows in increasing order is a valid
+ * program.
+ */
+typedef struct {
+	int	nb_symbols;	// n
+	int	nb_rows;	// n-k
+	int	nb_temps;	// number of temporaries
+	INT32	*temp_ops;	// 2 operands per temporary
+	INT32	*row_ptr;	// nb_rows+1 offsets in row_ops
+	INT32	*row_ops;	// operands of each row, in increasing order
+
+	// XOR sums of symbols (the first operand of a row being copied):
+	// sum over the rows of their number of symbols minus one without
+	// the schedule, nb_temps plus the same sum over row_ops with it.
+	int	naive_xors;
+	int	xors;
+} xor_schedule;
+
+/**
+ * Builds the schedule of the encoder of a parity check matrix.
+ * Each step counts the pairs of all the rows, so that building the
+ * schedule is quadratic in the number of entries: it is meant for small
+ * blocks, offline or at session creation.
+ * @param matrix	(IN) parity check matrix of the session.
+ * @param nbSourceSymbols (IN) k, to number the symbols.
+ * @return		the schedule (to be freed with xor_schedule_free), or
+ *			NULL if out of memory.
+ */
+xor_schedule* xor_schedule_build (mod2csr *matrix, int nbSourceSymbols);
+
+/**
+ * Frees a schedule.
+ */
+void xor_schedule_free (xor_schedule *schedule);
+
+#endif /* } LDPC_XOR_SCHEDULE_H */